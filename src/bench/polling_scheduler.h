@@ -0,0 +1,56 @@
+#ifndef __POLLING_SCHEDULER__H
+#define __POLLING_SCHEDULER__H
+
+#include <vector>
+#include "scheduler.h"
+
+namespace
+{
+
+    //! The same robots driven like the enviro StateMachine: every robot is looked at on every tick, and
+    //! resumed when its move or turn is over. The measurement reference for TaskScheduler, with the same
+    //! paths, used by wander_bench and wander_sim --scheduler poll.
+    class PollingScheduler
+    {
+    public:
+        PollingScheduler(std::vector<WandererTask> &tasks) : tasks(tasks), now(0), until(tasks.size(), 1), held(tasks.size(), 0) {}
+
+        void start() {}
+
+        long tick() {
+            now++;
+            long resumed = 0;
+            for (size_t i = 0; i < tasks.size(); i++) {
+                if (held[i] || now < until[i]) {
+                    continue; // during() of a state that waits
+                }
+                resumed++;
+                Suspension s = tasks[i].resume();
+                held[i] = s.kind == Suspension::INPUT;
+                until[i] = now + (s.ticks > 0 ? s.ticks : 1);
+            }
+            return resumed;
+        }
+
+        void take_over(size_t i) {
+            held[i] = 1;
+            tasks[i].take_over();
+        }
+
+        void signal(size_t i) {
+            held[i] = 0;
+            until[i] = now + 1;
+        }
+
+        long time() const { return now; }
+
+    private:
+        std::vector<WandererTask> &tasks;
+        long now;
+        std::vector<long> until;
+        std::vector<char> held;
+    };
+
+}
+
+#endif
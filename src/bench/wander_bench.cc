@@ -0,0 +1,477 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <chrono>
+#include <random>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <functional>
+#include "headless.h"
+#include "maze_gen.h"
+#include "player_input.h"
+#include "swarm.h"
+#include "scheduler.h"
+#include "polling_scheduler.h"
+#include "event_channel.h"
+#include "heatmap_stream.h"
+
+//! An event with the layout of elma's Event, to emit through an EventChannelOf without enviro.
+struct BenchEvent
+{
+    BenchEvent(const std::string &name) : name(name) {}
+    BenchEvent(const std::string &name, const nlohmann::json &value) : name(name), value(value) {}
+
+    std::string name;
+    nlohmann::json value;
+};
+
+// Micro and macro benchmarks of the wanderer controller.
+//
+// Usage: wander_bench [config.json] [-o bench.json] [--min-time s] [--filter text]
+//
+// Micro benchmarks time the SeenMap operations, one Checking decision and the copies made by emitting
+// the typed events of Checking, Moving and Rotating, the player's keyboard input and the batch decision
+// kernels of the swarm (per robot). Scheduler benchmarks time one tick of 10000 robots driven by the
+// task scheduler or polled like the state machine, with most of them held by the player. Macro benchmarks play full episodes on the shipped
+// maze and on generated ones. Results are written as JSON, one object per benchmark with ns/op and
+// allocations/op, plus decisions/s and steps-to-exit for the episodes.
+
+namespace
+{
+
+    //! Heap allocations made by the process, counted by the replaced operator new.
+    std::atomic<long> allocations(0);
+
+}
+
+void *operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+namespace
+{
+
+    //! Keeps the optimizer from dropping the benchmarked work.
+    volatile long sink;
+
+    //! Runs the benchmarks whose name matches the filter and collects their results.
+    class Bench
+    {
+    public:
+        Bench(double min_time, const std::string &filter) : min_time(min_time), filter(filter) {}
+
+        //! Times op(iterations), doubling the iterations until the run lasts at least min_time.
+        //! \param op (function) runs the operation n times.
+        //! \return the result object, or nullptr when the benchmark was filtered out.
+        nlohmann::json *run(const std::string &name, const std::string &kind, std::function<void(long)> op) {
+            if (name.find(filter) == std::string::npos) {
+                return nullptr;
+            }
+            op(1); // warm up
+            long iterations = 1;
+            for (;;) {
+                long before = allocations.load(std::memory_order_relaxed);
+                auto begin = std::chrono::steady_clock::now();
+                op(iterations);
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+                long allocated = allocations.load(std::memory_order_relaxed) - before;
+                if (seconds >= min_time || iterations >= (1L << 40)) {
+                    results.push_back({
+                        { "name", name },
+                        { "kind", kind },
+                        { "iterations", iterations },
+                        { "ns_per_op", seconds * 1e9 / iterations },
+                        { "allocations_per_op", (double) allocated / iterations }
+                    });
+                    std::cerr << name << ": " << seconds * 1e9 / iterations << " ns/op" << std::endl;
+                    return &results.back();
+                }
+                iterations *= 2;
+            }
+        }
+
+        //! Plays episodes from the top left block or from random starts, and adds the episode statistics.
+        //! \param corridors (CorridorMap) goes through corridors without deciding when given.
+        void episodes(const std::string &name, const MazeGrid &grid, long max_decisions, bool random_starts,
+                      const CorridorMap *corridors = nullptr) {
+            SeenMap seen(grid.width(), grid.height());
+            HeadlessWanderer wanderer(grid, seen);
+            wanderer.fast_forward(corridors);
+            std::mt19937 rng(1);
+            long exited = 0, steps = 0, decisions = 0;
+            nlohmann::json *result = run(name, "macro", [&](long n) {
+                exited = steps = decisions = 0;
+                for (long i = 0; i < n; i++) {
+                    int x = 0, y = 0, heading = MazeGrid::RIGHT;
+                    if (random_starts) {
+                        x = rng() % grid.width();
+                        y = rng() % grid.height();
+                        heading = rng() % 4;
+                    }
+                    EpisodeResult r = wanderer.run_episode(x, y, heading, max_decisions);
+                    decisions += r.decisions;
+                    if (r.exited) {
+                        exited++;
+                        steps += r.steps;
+                    }
+                }
+            });
+            if (result == nullptr) {
+                return;
+            }
+            long n = (*result)["iterations"];
+            double seconds = (*result)["ns_per_op"].get<double>() * n / 1e9;
+            (*result)["maze"] = std::to_string(grid.width()) + "x" + std::to_string(grid.height());
+            (*result)["exited"] = (double) exited / n;
+            (*result)["decisions_per_op"] = (double) decisions / n;
+            (*result)["decisions_per_s"] = decisions / seconds;
+            (*result)["steps_to_exit"] = exited > 0 ? (double) steps / exited : 0.0;
+        }
+
+        nlohmann::json results = nlohmann::json::array();
+
+    private:
+        double min_time;
+        std::string filter;
+    };
+
+}
+
+int main(int argc, char **argv) {
+    std::string config = "config.json";
+    std::string output;
+    std::string filter;
+    double min_time = 0.2;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            min_time = std::atof(argv[++i]);
+        } else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg[0] != '-') {
+            config = arg;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [config.json] [-o bench.json] [--min-time s] [--filter text]" << std::endl;
+            return 1;
+        }
+    }
+
+    MazeGrid classic;
+    try {
+        classic = MazeGrid::load(config);
+    } catch (std::exception &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return 1;
+    }
+    Bench bench(min_time, filter);
+
+    // SeenMap operations over the blocks of the shipped maze
+    SeenMap seen(classic.width(), classic.height());
+    int blocks = classic.width() * classic.height();
+    bench.run("seen_map.get_value", "micro", [&](long n) {
+        long sum = 0;
+        for (long i = 0; i < n; i++) {
+            sum += seen.get_value(i % classic.width(), i / classic.width() % classic.height());
+        }
+        sink = sum;
+    });
+    bench.run("seen_map.set_to_visited", "micro", [&](long n) {
+        for (long i = 0; i < n; i++) {
+            seen.set_to_visited(i % classic.width(), i / classic.width() % classic.height());
+        }
+    });
+    bench.run("seen_map.reset_map", "micro", [&](long n) {
+        for (long i = 0; i < n; i++) {
+            seen.reset_map();
+        }
+    });
+    seen.reset_map();
+
+    // One Checking decision, cycling through every block and heading with a used visit map
+    GridBody body(classic);
+    MazeExit exit = MazeExit::of(classic);
+    std::mt19937 rng(1);
+    for (int i = 0; i < 4 * blocks; i++) {
+        seen.set_to_visited(rng() % classic.width(), rng() % classic.height());
+    }
+    bench.run("checking.decision", "micro", [&](long n) {
+        long sum = 0;
+        for (long i = 0; i < n; i++) {
+            long pose = i % (blocks * 4);
+            body.x = pose / 4 % classic.width();
+            body.y = pose / 4 / classic.width();
+            body.heading = pose % 4;
+            Decision d = wander_decision(body, body.pose(), seen, exit);
+            sum += d.x + d.rate;
+        }
+        sink = sum;
+    });
+
+    // Emitting Moving and Rotating through the EventChannel of the controller: the prebuilt event is
+    // copied like elma copies it on emit(), and the entered state reads the payload back. The event type
+    // has the layout of elma's, a name and a json value. The same event with a json payload built and
+    // parsed on every emit, as the UI events still are, is the reference
+    EventChannelOf<BenchEvent> channel("0");
+    bench.run("moving.event", "micro", [&](long n) {
+        long sum = 0;
+        for (long i = 0; i < n; i++) {
+            BenchEvent e = channel.moving_to(i & 7, i >> 3 & 7);
+            sum += e.name.size() + e.value.is_null() + channel.cell_x + channel.cell_y;
+        }
+        sink = sum;
+    });
+    bench.run("rotating.event", "micro", [&](long n) {
+        long sum = 0;
+        for (long i = 0; i < n; i++) {
+            BenchEvent e = channel.rotating((int) (i % 3) - 1);
+            sum += e.name.size() + e.value.is_null() + channel.turn;
+        }
+        sink = sum;
+    });
+    bench.run("moving.json_event", "micro", [&](long n) {
+        long sum = 0;
+        for (long i = 0; i < n; i++) {
+            BenchEvent e(channel.move, { (int) i & 7, (int) i >> 3 & 7 });
+            sum += e.name.size() + e.value[0].get<int>() + e.value[1].get<int>();
+        }
+        sink = sum;
+    });
+
+    // The keyboard input of the player: an auto-repeat of a held key, which only costs a lookup, and a
+    // key change merged into the command read once per tick
+    PlayerInput input;
+    auto now = std::chrono::steady_clock::now();
+    input.press("w", now);
+    bench.run("player_input.repeat", "micro", [&](long n) {
+        for (long i = 0; i < n; i++) {
+            input.press("w", now);
+        }
+        sink = input.statistics().repeats;
+    });
+    bench.run("player_input.change_and_apply", "micro", [&](long n) {
+        double v = 0, av = 0, sum = 0;
+        for (long i = 0; i < n; i++) {
+            if (i & 1) {
+                input.release("d", now);
+            } else {
+                input.press("d", now);
+            }
+            input.apply(v, av, now);
+            sum += v + av;
+        }
+        sink = (long) sum;
+    });
+
+    // Mapping world positions to blocks and back: the seven-step scan GoToClosestCenter used, the layout
+    // of the shipped maze, and one with blocks of 128 mapped with a shift
+    std::vector<double> xs(1024);
+    for (size_t i = 0; i < xs.size(); i++) {
+        xs[i] = -350.0 + (rng() % 70000) / 100.0;
+    }
+    bench.run("geometry.scan", "micro", [&](long n) {
+        double sum = 0;
+        for (long i = 0; i < n; i++) {
+            double x = xs[i & 1023], y = xs[(i + 1) & 1023], grid_x = 0, grid_y = 0;
+            for (int j = 0; j < 7; j++) {
+                if (x >= -350 + j * 100 && x < -350 + (j + 1) * 100) {
+                    grid_x = 50.0 + j * 100.0 - 350.0;
+                }
+                if (y >= -350 + j * 100 && y < -350 + (j + 1) * 100) {
+                    grid_y = 50.0 + j * 100.0 - 350.0;
+                }
+            }
+            sum += grid_x + grid_y;
+        }
+        sink = (long) sum;
+    });
+    GridGeometry shipped = GridGeometry::of(classic), power_of_two(7, 7, 128.0, -448.0, -448.0, 6, 6, MazeGrid::DOWN);
+    for (const GridGeometry *geometry : { &shipped, &power_of_two }) {
+        const GridGeometry &g = *geometry;
+        nlohmann::json *result = bench.run(g.kind() == GridGeometry::POWER_OF_TWO ? "geometry.power_of_two" : "geometry.generic", "micro", [&](long n) {
+            double sum = 0;
+            for (long i = 0; i < n; i++) {
+                int x, y;
+                g.block_of(xs[i & 1023], xs[(i + 1) & 1023], x, y);
+                sum += g.center_x(x) + g.center_y(y);
+            }
+            sink = (long) sum;
+        });
+        if (result != nullptr && geometry == &shipped && classic.width() == 7 && classic.height() == 7) {
+            // The shipped maze: blocks of 100 from (-350, -350), left through the bottom of block (6, 6)
+            bool layout = g.exit_x() == 300.0 && g.exit_y() == 350.0;
+            for (int i = 0; i < 7; i++) {
+                layout = layout && g.center_x(i) == -300.0 + 100.0 * i && g.center_y(i) == -300.0 + 100.0 * i;
+            }
+            (*result)["shipped_layout"] = layout;
+        }
+    }
+
+    // The least visited rule for 4096 robots at once, per robot, with every kernel the processor runs
+    const int robots = 4096;
+    std::vector<int32_t> open(robots), front(robots), right(robots), left(robots), turn(robots), expected(robots);
+    for (int i = 0; i < robots; i++) {
+        open[i] = rng() % 8;
+        front[i] = rng() % 4;
+        right[i] = rng() % 4;
+        left[i] = rng() % 4;
+    }
+    swarm::decide_scalar(open.data(), front.data(), right.data(), left.data(), expected.data(), robots);
+    for (swarm::Kernel kernel : { swarm::SCALAR, swarm::SSE2, swarm::AVX2 }) {
+        if (kernel > swarm::best_kernel()) {
+            continue;
+        }
+        nlohmann::json *result = bench.run(std::string("swarm.kernel_") + swarm::kernel_name(kernel), "micro", [&](long n) {
+            for (long i = 0; i < n; i += robots) {
+                swarm::decide_batch(kernel, open.data(), front.data(), right.data(), left.data(), turn.data(), robots);
+            }
+            sink = turn[n % robots];
+        });
+        if (result != nullptr) {
+            (*result)["identical"] = turn == expected;
+        }
+    }
+
+    // One tick of 10000 robots, 1 in 10 wandering and the others held by the player
+    const int fleet = 10000;
+    auto ticks = [&](const std::string &name, bool polling) {
+        std::vector<SeenMap> maps;
+        std::vector<HeadlessWanderer> robots;
+        std::vector<WandererTask> tasks;
+        maps.reserve(fleet);
+        robots.reserve(fleet);
+        tasks.reserve(fleet);
+        for (int i = 0; i < fleet; i++) {
+            maps.emplace_back(classic.width(), classic.height());
+            robots.emplace_back(classic, maps.back());
+            tasks.emplace_back(robots.back(), 20, 5, 1000000);
+            tasks.back().start(i % classic.width(), i / classic.width() % classic.height(), i % 4);
+        }
+        TaskScheduler scheduler(tasks);
+        PollingScheduler poller(tasks);
+        scheduler.start();
+        for (int i = 0; i < fleet; i++) {
+            if (i % 10 != 0) {
+                if (polling) {
+                    poller.take_over(i);
+                } else {
+                    scheduler.take_over(i);
+                }
+            }
+        }
+        long resumed = 0, elapsed = 0;
+        nlohmann::json *result = bench.run(name, "macro", [&](long n) {
+            for (long i = 0; i < n; i++) {
+                resumed += polling ? poller.tick() : scheduler.tick();
+                elapsed++;
+            }
+        });
+        if (result != nullptr) {
+            (*result)["robots"] = fleet;
+            (*result)["resumed_per_tick"] = (double) resumed / elapsed;
+        }
+    };
+    ticks("scheduler.tasks_10000", false);
+    ticks("scheduler.polling_10000", true);
+
+    // Full episodes
+    bench.episodes("episode.classic", classic, 1000000, false);
+    bench.episodes("episode.classic_random_starts", classic, 1000000, true);
+    MazeGrid perfect = MazeGenerator::generate(100, 100, "backtracker", 1);
+    bench.episodes("episode.backtracker_100x100", perfect, 100000000, false);
+    CorridorMap corridors(perfect, MazeExit::of(perfect));
+    bench.episodes("episode.backtracker_100x100_fast_forward", perfect, 100000000, false, &corridors);
+    MazeGrid braided = MazeGenerator::generate(500, 500, "kruskal", 1, 0.5);
+    bench.episodes("episode.kruskal_braided_500x500", braided, 100000000, false);
+
+    // One frame of the heatmap on the 500x500 maze: the robot counts one more visit, the feed sends the
+    // delta, the overlay patches it and the decoration is built and copied as HeatmapController hands
+    // it to enviro, with 1000 blocks visited and with the whole maze visited, where the overlay draws
+    // its default 10000 blocks at most
+    for (int visited : { 1000, 250000 }) {
+        SeenMap counts(braided.width(), braided.height());
+        HeatmapFeed feed(0);
+        HeatmapOverlay overlay(-350.0, -350.0, 100.0, "orangered", 8);
+        nlohmann::json message;
+        for (int i = 0; i < visited; i++) {
+            counts.set_to_visited(i % counts.width(), i / counts.width());
+        }
+        feed.collect(counts, message);
+        overlay.apply(message);
+        overlay.take_change();
+        size_t bytes = 0;
+        nlohmann::json *result = bench.run("heatmap.frame_" + std::to_string(visited) + "_visited", "micro", [&](long n) {
+            for (long i = 0; i < n; i++) {
+                int b = (int) (i % 1000); // A drawn block, every frame changes the drawing
+                counts.set_to_visited(b % counts.width(), b / counts.width());
+                feed.touched(b % counts.width(), b / counts.width());
+                feed.collect(counts, message);
+                overlay.apply(message);
+                if (overlay.take_change()) {
+                    std::string decoration = "<g transform='rotate(0) translate(0,0)'>" + overlay.svg() + "</g>";
+                    bytes = decoration.size();
+                }
+            }
+            sink = (long) bytes;
+        });
+        if (result != nullptr) {
+            (*result)["blocks_drawn"] = overlay.blocks();
+            (*result)["decoration_bytes"] = bytes;
+        }
+    }
+
+    // A rollout of the lookahead planner: fork a visit snapshot and play 32 decisions on it, on the
+    // shipped maze and on the 500x500 one. Forking copies the touched blocks, not the map
+    for (const MazeGrid *grid : { &classic, &braided }) {
+        SeenMap base(grid->width(), grid->height());
+        VisitSnapshot root(base);
+        GridBody walker(*grid);
+        MazeExit way_out = MazeExit::of(*grid);
+        bench.run(grid == &classic ? "planner.rollout_classic" : "planner.rollout_500x500", "micro", [&](long n) {
+            long sum = 0;
+            for (long i = 0; i < n; i++) {
+                VisitSnapshot snapshot = root.fork(32);
+                GridPose pose = { 0, 0, MazeGrid::RIGHT, true };
+                for (int t = 0; t < 32; t++) {
+                    Decision d = wander_decision(walker, pose, snapshot, way_out);
+                    if (d.kind == Decision::ROTATE) {
+                        pose.rotate(d.rate);
+                    } else if (grid->in_bounds(d.x, d.y)) {
+                        snapshot.set_to_visited(pose.x, pose.y);
+                        pose.x = d.x;
+                        pose.y = d.y;
+                    }
+                }
+                sum += snapshot.touched();
+            }
+            sink = sum;
+        });
+    }
+
+    nlohmann::json report = {
+        { "config", config },
+        { "compiler", __VERSION__ },
+        { "min_time", min_time },
+        { "benchmarks", bench.results }
+    };
+    if (output.empty()) {
+        std::cout << report.dump(2) << std::endl;
+    } else {
+        std::ofstream out(output);
+        out << report.dump(2) << std::endl;
+        if (!out) {
+            std::cerr << "error: could not write " << output << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+#ifndef __CORRIDORS__H
+#define __CORRIDORS__H
+
+#include <array>
+#include <vector>
+#include "maze_grid.h"
+#include "wander_policy.h"
+
+namespace
+{
+
+    //! Heading to leave a corridor block with the given wall mask when it was entered with the given heading,
+    //! indexed by walls * 4 + heading. -1 when the block is not a corridor (more or less than two open edges)
+    //! or when its open edges do not include the one the robot came through.
+    constexpr std::array<signed char, 16 * 4> make_corridor_table() {
+        std::array<signed char, 16 * 4> table = {};
+        for (int walls = 0; walls < 16; walls++) {
+            int open = 0;
+            for (int h = 0; h < 4; h++) {
+                open += !(walls >> h & 1);
+            }
+            for (int heading = 0; heading < 4; heading++) {
+                int back = (heading + 2) & 3;
+                table[walls * 4 + heading] = -1;
+                if (open != 2 || (walls >> back & 1)) {
+                    continue;
+                }
+                for (int h = 0; h < 4; h++) {
+                    if (h != back && !(walls >> h & 1)) {
+                        table[walls * 4 + heading] = h;
+                    }
+                }
+            }
+        }
+        return table;
+    }
+
+    constexpr std::array<signed char, 16 * 4> CORRIDOR_TABLE = make_corridor_table();
+
+    //! The decision points of a maze, used to go through whole corridors without stopping to decide.
+    //!
+    //! A block with exactly two open edges leaves only one way to go once the robot is in it, so the robot
+    //! can carry on until the next junction (more than two open edges), dead end, or the exit block. The
+    //! junction flags are computed once, a corridor is then followed with one table lookup per block.
+    class CorridorMap
+    {
+    public:
+        CorridorMap() : grid(nullptr) {}
+
+        //! \param grid (MazeGrid) the maze, must outlive the map.
+        //! \param exit (MazeExit) the exit block is always a decision point.
+        CorridorMap(const MazeGrid &grid, const MazeExit &exit) : grid(&grid), stops((size_t) grid.width() * grid.height(), 0) {
+            for (int y = 0; y < grid.height(); y++) {
+                for (int x = 0; x < grid.width(); x++) {
+                    int mask = grid.wall_mask(x, y);
+                    stops[(size_t) y * grid.width() + x] = CORRIDOR_TABLE[mask * 4] < 0 && CORRIDOR_TABLE[mask * 4 + 1] < 0
+                                                        && CORRIDOR_TABLE[mask * 4 + 2] < 0 && CORRIDOR_TABLE[mask * 4 + 3] < 0;
+                }
+            }
+            if (grid.in_bounds(exit.x, exit.y)) {
+                stops[(size_t) exit.y * grid.width() + exit.x] = 1;
+            }
+        }
+
+        //! \return the heading to carry on through block (x, y) entered with the given heading, or -1 when
+        //! the robot has to stop and decide there.
+        int pass_heading(int x, int y, int heading) const {
+            if (!grid->in_bounds(x, y) || stops[(size_t) y * grid->width() + x]) {
+                return -1;
+            }
+            int out = CORRIDOR_TABLE[grid->wall_mask(x, y) * 4 + (heading & 3)];
+            return out >= 0 && grid->in_bounds(x + MazeGrid::dx(out), y + MazeGrid::dy(out)) ? out : -1;
+        }
+
+        //! Follows the corridor from block (x, y) entered with the given heading, up to the next decision point.
+        //! \param pass called as pass(x, y, heading, out) for every block gone through, before leaving it
+        //! with the heading out.
+        //! \return the number of blocks gone through, (x, y) and heading receive the decision point.
+        template <class Pass>
+        long follow(int &x, int &y, int &heading, Pass pass) const {
+            long passed = 0;
+            for (int out; (out = pass_heading(x, y, heading)) >= 0 && passed < (long) stops.size(); passed++) {
+                pass(x, y, heading, out);
+                heading = out;
+                x += MazeGrid::dx(out);
+                y += MazeGrid::dy(out);
+            }
+            return passed;
+        }
+
+        bool empty() const { return grid == nullptr; }
+
+    private:
+        const MazeGrid *grid;
+        //! One flag per block, set on junctions, dead ends and the exit.
+        std::vector<unsigned char> stops;
+    };
+
+}
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef __EVALUATION__H
+#define __EVALUATION__H
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+
+namespace
+{
+
+    //! Runs a fixed set of independent jobs on several threads with work stealing.
+    //!
+    //! Every worker owns a contiguous range of job indices packed into one 64-bit atomic, the first index
+    //! in the low half and the end in the high half. A worker takes jobs from the front of its own range,
+    //! and when it runs out steals the back half of the largest range it can find, so the threads stay
+    //! busy even when some jobs (long episodes, big mazes) take much longer than others. Both operations
+    //! are a single compare-and-swap, no lock is ever taken.
+    class WorkStealingPool
+    {
+    public:
+        //! \param threads (int) number of worker threads.
+        WorkStealingPool(int threads) : workers(std::max(1, threads)), ranges(new Range[workers]) {}
+
+        //! Runs job(index, worker) for every index in [0, jobs) and waits for all of them.
+        //! \param job called with the job index and the index of the worker thread running it, so
+        //! the job can use per-worker state without any locking.
+        template <class Job>
+        void run(uint32_t jobs, Job job) {
+            for (int w = 0; w < workers; w++) {
+                uint32_t begin = (uint64_t) jobs * w / workers, end = (uint64_t) jobs * (w + 1) / workers;
+                ranges[w].value.store(pack(begin, end), std::memory_order_relaxed);
+            }
+            std::vector<std::thread> threads;
+            for (int w = 1; w < workers; w++) {
+                threads.emplace_back([this, w, &job]() { work(w, job); });
+            }
+            work(0, job);
+            for (auto &t : threads) {
+                t.join();
+            }
+        }
+
+        int size() const { return workers; }
+
+    private:
+        //! One range per worker, on its own cache line so the owners do not slow each other down.
+        struct alignas(64) Range
+        {
+            std::atomic<uint64_t> value{ 0 };
+        };
+
+        static uint64_t pack(uint32_t begin, uint32_t end) { return (uint64_t) end << 32 | begin; }
+        static uint32_t begin_of(uint64_t r) { return (uint32_t) r; }
+        static uint32_t end_of(uint64_t r) { return (uint32_t) (r >> 32); }
+
+        template <class Job>
+        void work(int w, Job &job) {
+            uint32_t index;
+            while (pop(w, index) || (steal(w) && pop(w, index))) {
+                job(index, w);
+            }
+        }
+
+        //! Takes the first job of worker w's own range.
+        bool pop(int w, uint32_t &index) {
+            std::atomic<uint64_t> &range = ranges[w].value;
+            uint64_t r = range.load(std::memory_order_relaxed);
+            while (begin_of(r) < end_of(r)) {
+                if (range.compare_exchange_weak(r, pack(begin_of(r) + 1, end_of(r)), std::memory_order_relaxed)) {
+                    index = begin_of(r);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        //! Moves the back half of the largest other range into worker w's own (empty) range.
+        //! \return false when there is nothing left to steal.
+        bool steal(int w) {
+            for (;;) {
+                int victim = -1;
+                uint64_t r = 0;
+                uint32_t largest = 0;
+                for (int v = 0; v < workers; v++) {
+                    uint64_t candidate = ranges[v].value.load(std::memory_order_relaxed);
+                    uint32_t left = end_of(candidate) > begin_of(candidate) ? end_of(candidate) - begin_of(candidate) : 0;
+                    if (v != w && left > largest) {
+                        victim = v;
+                        r = candidate;
+                        largest = left;
+                    }
+                }
+                if (victim < 0) {
+                    return false;
+                }
+                uint32_t take = (largest + 1) / 2, split = end_of(r) - take;
+                if (ranges[victim].value.compare_exchange_strong(r, pack(begin_of(r), split), std::memory_order_relaxed)) {
+                    ranges[w].value.store(pack(split, split + take), std::memory_order_relaxed);
+                    return true;
+                }
+            }
+        }
+
+        int workers;
+        std::unique_ptr<Range[]> ranges;
+    };
+
+    //! Summary of a set of steps-to-exit samples.
+    struct StepStatistics
+    {
+        long count = 0;     //!< number of episodes
+        long exited = 0;    //!< episodes where the robot got out
+        double mean = 0;    //!< of the exited episodes
+        long p50 = 0;
+        long p90 = 0;
+        long p99 = 0;
+        long worst = 0;
+
+        //! \param steps (vector) steps to exit of every episode, -1 for the episodes that did not exit.
+        static StepStatistics of(std::vector<long> steps) {
+            StepStatistics s;
+            s.count = steps.size();
+            steps.erase(std::remove(steps.begin(), steps.end(), -1L), steps.end());
+            s.exited = steps.size();
+            if (steps.empty()) {
+                return s;
+            }
+            std::sort(steps.begin(), steps.end());
+            double total = 0;
+            for (long v : steps) {
+                total += v;
+            }
+            s.mean = total / steps.size();
+            auto percentile = [&](double p) { return steps[std::min(steps.size() - 1, (size_t) (p * steps.size()))]; };
+            s.p50 = percentile(0.50);
+            s.p90 = percentile(0.90);
+            s.p99 = percentile(0.99);
+            s.worst = steps.back();
+            return s;
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef __EVENT_CHANNEL__H
+#define __EVENT_CHANNEL__H
+
+#include <string>
+
+namespace
+{
+
+    //! Names of the events a WandererController reacts to. Every controller gets its own names, so the
+    //! state machines of several robots never react to each other's events.
+    struct EventNames
+    {
+        //! \param suffix (string) added to every name, unique to one robot.
+        EventNames(const std::string &suffix)
+            : move("move_" + suffix), rotate("rotate_" + suffix), check("check_" + suffix),
+              restart("restart_" + suffix), play("play_" + suffix), gtcc("gtcc_" + suffix) {}
+
+        std::string move;
+        std::string rotate;
+        std::string check;
+        std::string restart;
+        std::string play;
+        std::string gtcc;
+    };
+
+    //! The events of one WandererController, with typed payloads.
+    //!
+    //! Every event is built once with its name and no value, and the payload of the last emitted event is
+    //! kept in plain fields that the entered state reads back. elma delivers an event to the state machine
+    //! before emit() returns, so no other event can overwrite the payload in between. Copying a prebuilt
+    //! event does not allocate: the names fit in the small string buffer and the json value is null.
+    //! JSON payloads are only parsed at the UI boundary, in UserInputController.
+    //!
+    //! The event type is a parameter so the channel does not depend on enviro: wanderer.h uses elma's
+    //! Event, the benchmarks a type with the same layout, a name and a json value.
+    template <class EventType>
+    class EventChannelOf : public EventNames
+    {
+    public:
+        //! \param suffix (string) added to every name, unique to one robot.
+        EventChannelOf(const std::string &suffix)
+            : EventNames(suffix), move_event(move), rotate_event(rotate), check_event(check),
+              restart_event(restart), play_event(play), gtcc_event(gtcc) {}
+
+        //! Go to block (x, y).
+        const EventType &moving_to(int x, int y) {
+            cell_x = x;
+            cell_y = y;
+            return move_event;
+        }
+
+        //! Rotate 90 degrees, clockwise when rate is 1, counter-clockwise when rate is -1, 0 snaps to the closest heading.
+        const EventType &rotating(int rate) {
+            turn = rate;
+            return rotate_event;
+        }
+
+        const EventType &checking() const { return check_event; }
+
+        //! Go back to the start, then let the player drive when player is 1.
+        const EventType &restarting(int player) {
+            restart_player = player;
+            return restart_event;
+        }
+
+        //! Drive with the given velocity and angular velocity.
+        const EventType &playing(double v, double omega) {
+            velocity = v;
+            angular_velocity = omega;
+            return play_event;
+        }
+
+        //! Go to the center of the current block, then solve the maze when solve is 1, wander otherwise.
+        const EventType &going_to_center(int solve) {
+            solve_after = solve;
+            return gtcc_event;
+        }
+
+        // Payload of the last event of each kind
+        int cell_x = 0;
+        int cell_y = 0;
+        int turn = 0;
+        int restart_player = 0;
+        double velocity = 0;
+        double angular_velocity = 0;
+        int solve_after = 0;
+
+    private:
+        const EventType move_event;
+        const EventType rotate_event;
+        const EventType check_event;
+        const EventType restart_event;
+        const EventType play_event;
+        const EventType gtcc_event;
+    };
+
+}
+
+#endif
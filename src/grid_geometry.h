@@ -0,0 +1,107 @@
+#ifndef __GRID_GEOMETRY__H
+#define __GRID_GEOMETRY__H
+
+#include <math.h>
+#include <algorithm>
+#include "maze_grid.h"
+
+namespace
+{
+
+    //! The layout of the maze the robots run in, configured at run time.
+    //!
+    //! A world position is mapped to its block with a shift when the block size is a power of two on an
+    //! integer origin, and with a multiplication by the inverse block size otherwise. The layout is picked
+    //! once, the branch on it is always predicted.
+    class GridGeometry
+    {
+    public:
+        enum Layout { GENERIC, POWER_OF_TWO };
+
+        //! \param width (int) number of columns.
+        //! \param height (int) number of rows.
+        //! \param cell (double) width of one block in world units.
+        //! \param left (double) world x position of the left edge of the maze.
+        //! \param top (double) world y position of the top edge of the maze.
+        //! \param exit_x (int) column of the block the robot leaves from.
+        //! \param exit_y (int) row of that block.
+        //! \param exit_heading (int) heading of its open outer edge.
+        GridGeometry(int width, int height, double cell, double left, double top, int exit_x, int exit_y, int exit_heading)
+            : grid_width(width), grid_height(height), cell(cell), inverse_cell(1.0 / cell), left(left), top(top),
+              shift(0), layout(GENERIC) {
+            exit_point_x = center_x(exit_x) + MazeGrid::dx(exit_heading) * cell / 2;
+            exit_point_y = center_y(exit_y) + MazeGrid::dy(exit_heading) * cell / 2;
+            int size = (int) cell;
+            if (size == cell && size > 0 && (size & (size - 1)) == 0 && left == std::floor(left) && top == std::floor(top)) {
+                layout = POWER_OF_TWO;
+                while ((1 << shift) < size) {
+                    shift++;
+                }
+            }
+        }
+
+        //! The layout of the shipped maze.
+        GridGeometry() : GridGeometry(7, 7, 100.0, -350.0, -350.0, 6, 6, MazeGrid::DOWN) {}
+
+        //! \return the layout of a loaded maze, with the exit found on its boundary.
+        static GridGeometry of(const MazeGrid &grid) {
+            int x = 6, y = 6, heading = MazeGrid::DOWN;
+            grid.find_exit(x, y, heading);
+            return GridGeometry(grid.width(), grid.height(), grid.cell_size(), grid.origin_x(), grid.origin_y(), x, y, heading);
+        }
+
+        int width() const { return grid_width; }
+        int height() const { return grid_height; }
+        Layout kind() const { return layout; }
+
+        //! World position of the center of column i / row j.
+        double center_x(int i) const { return left + (i + 0.5) * cell; }
+        double center_y(int j) const { return top + (j + 0.5) * cell; }
+
+        //! Column / row of a world position, outside of the maze when the position is.
+        int column(double x) const {
+            if (layout == POWER_OF_TWO) {
+                return ((int) std::floor(x) - (int) left) >> shift;
+            }
+            return (int) std::floor((x - left) * inverse_cell);
+        }
+        int row(double y) const {
+            if (layout == POWER_OF_TWO) {
+                return ((int) std::floor(y) - (int) top) >> shift;
+            }
+            return (int) std::floor((y - top) * inverse_cell);
+        }
+
+        bool contains(int i, int j) const { return i >= 0 && j >= 0 && i < grid_width && j < grid_height; }
+
+        //! The block of a world position, the closest block of the maze when the position is outside.
+        void block_of(double x, double y, int &i, int &j) const {
+            i = std::min(std::max(column(x), 0), grid_width - 1);
+            j = std::min(std::max(row(y), 0), grid_height - 1);
+        }
+
+        //! The middle of the open outer edge of the exit block, where the robot leaves the maze.
+        double exit_x() const { return exit_point_x; }
+        double exit_y() const { return exit_point_y; }
+
+        //! \return true when a world position is past the right or the bottom edge of the maze.
+        bool past_edge(double x, double y) const {
+            return x >= left + grid_width * cell || y >= top + grid_height * cell;
+        }
+
+    private:
+        int grid_width;
+        int grid_height;
+        double cell;
+        double inverse_cell;
+        double left;
+        double top;
+        double exit_point_x;
+        double exit_point_y;
+        int shift;
+        Layout layout;
+    };
+
+}
+
+#endif
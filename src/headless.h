@@ -0,0 +1,298 @@
+#ifndef __HEADLESS__H
+#define __HEADLESS__H
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include "maze_grid.h"
+#include "seen_map.h"
+#include "wander_policy.h"
+#include "maze_solver.h"
+#include "corridors.h"
+#include "trajectory.h"
+#include "policies.h"
+#include "visit_stats.h"
+#include "planner.h"
+
+namespace
+{
+
+    //! A grid based stand-in for the enviro AgentInterface used by the headless simulator.
+    //!
+    //! The robot always sits at the center of a block and faces one of the four headings, so its pose is
+    //! the grid pose and open_sides() can be answered from the MazeGrid without any physics.
+    class GridBody
+    {
+    public:
+        GridBody(const MazeGrid &grid) : grid(grid), x(0), y(0), heading(MazeGrid::RIGHT) {}
+
+        GridPose pose() const { return { x, y, heading, true }; }
+
+        int open_sides(int x, int y, int heading) const {
+            return grid.open_sides(x, y, heading);
+        }
+
+        const MazeGrid &grid;
+        int x;
+        int y;
+        int heading;
+    };
+
+    //! Statistics of a single headless episode.
+    struct EpisodeResult
+    {
+        bool exited;    //!< true when the robot left the maze before running out of decisions
+        long steps;     //!< number of blocks moved
+        long rotations; //!< number of 90 degree turns
+        long decisions; //!< number of Checking decisions
+    };
+
+    //! Runs the Checking / Moving / Rotating / Restart cycle of WandererController on a MazeGrid,
+    //! one decision per iteration instead of one enviro tick per frame.
+    class HeadlessWanderer
+    {
+    public:
+        //! \param grid (MazeGrid) the maze to play in.
+        //! \param seen (SeenMap) the visit map of the robot, private or shared with other robots.
+        //! \param solver (MazeSolver) when given, the robot follows the solver like the "Solve" mode instead of wandering.
+        HeadlessWanderer(const MazeGrid &grid, SeenMap &seen, MazeSolver *solver = nullptr)
+            : body(grid), seen(&seen), solver(solver), maze_exit(MazeExit::of(grid)), corridors(nullptr),
+              ties(0), recorder(nullptr), policy(nullptr), stats(nullptr), planner(nullptr), result({ false, 0, 0, 0 }) {}
+
+        //! Makes the wandering robot go through whole corridors after each step, like the fast forward
+        //! mode of Moving, instead of deciding again in every block.
+        //! \param map (CorridorMap) the decision points of the maze, null to decide in every block.
+        void fast_forward(const CorridorMap *map) { corridors = map; }
+
+        //! Makes the robot wander with another policy than the least visited rule.
+        //! \param explorer (ExplorationPolicy) null for the built-in least visited rule.
+        void explore_with(ExplorationPolicy *explorer) { policy = explorer; }
+
+        //! Makes the wandering robot plan its moves by playing the least visited rule ahead.
+        //! \param lookahead (LookaheadPlanner) planning on the same maze, null to decide greedily.
+        void plan_with(LookaheadPlanner *lookahead) { planner = lookahead; }
+
+        //! Breaks the ties of the wander policy at random.
+        //! \param seed (uint64_t) 0 to break them front first, then right, like the plugin.
+        void tie_break(uint64_t seed) {
+            ties = seed == 0 ? 0 : seed * 0x9E3779B97F4A7C15ull | 1;
+        }
+
+        //! Appends every decision and every block passed in fast forward to a trajectory, one tick per decision.
+        //! \param trajectory (TrajectoryRecorder) null to stop recording.
+        void record(TrajectoryRecorder *trajectory) { recorder = trajectory; }
+
+        //! Adds every step, dead end and episode to long-lived statistics, like the plugin.
+        //! \param feed (VisitStatsFeed) null to stop counting.
+        void count_visits(VisitStatsFeed *feed) { stats = feed; }
+
+        //! Places the robot like the Restart state does and clears the episode statistics and the policy.
+        //! The visit map is left alone, it may be shared with other robots.
+        //! \param start_x (int) starting column.
+        //! \param start_y (int) starting row.
+        //! \param start_heading (int) starting heading, 0 is right.
+        void start(int start_x, int start_y, int start_heading) {
+            body.x = start_x;
+            body.y = start_y;
+            body.heading = start_heading;
+            result = { false, 0, 0, 0 };
+            if (policy != nullptr) {
+                policy->reset();
+            }
+            if (planner != nullptr) {
+                planner->reset();
+            }
+        }
+
+        //! Makes one Checking decision and applies it.
+        //! \return true when the robot left the maze.
+        bool step() {
+            Decision d;
+            bool wandering = solver == nullptr || !solver->decide(body.x, body.y, body.heading, d);
+            if (wandering && planner != nullptr) {
+                d = planner->decide(body.pose(), *seen);
+            } else if (wandering && policy != nullptr) {
+                d = explore_decision(body, body.pose(), *seen, maze_exit, *policy);
+            } else if (wandering) {
+                d = wander_decision(body, body.pose(), *seen, maze_exit, ties != 0 ? &ties : nullptr);
+            }
+            result.decisions++;
+            if (recorder != nullptr) {
+                recorder->tick();
+                recorder->decided(body.pose(), body.open_sides(body.x, body.y, body.heading), d, *seen);
+            }
+            if (d.kind == Decision::ROTATE) {
+                if (stats != nullptr && wandering && body.open_sides(body.x, body.y, body.heading) == 0
+                    && !(body.x == maze_exit.x && body.y == maze_exit.y)) {
+                    stats->dead_end(body.x, body.y);
+                }
+                body.heading = (body.heading + d.rate + 4) & 3;
+                result.rotations++;
+                return false;
+            }
+            // Same bookkeeping as Moving::entry, the block being left is marked as visited
+            seen->set_to_visited(body.x, body.y);
+            result.steps++;
+            if (stats != nullptr) {
+                stats->stepped(body.x, body.y);
+            }
+            if (!body.grid.in_bounds(d.x, d.y)) {
+                result.exited = true; // Robot at maze exit
+                if (stats != nullptr) {
+                    stats->episode_end(true);
+                }
+                return true;
+            }
+            body.x = d.x;
+            body.y = d.y;
+            if (wandering && corridors != nullptr && (policy == nullptr || policy->follows_corridors())) {
+                result.steps += corridors->follow(body.x, body.y, body.heading, [&](int x, int y, int heading, int out) {
+                    if (recorder != nullptr) {
+                        recorder->passed({ x, y, heading, true }, out, *seen);
+                    }
+                    seen->set_to_visited(x, y);
+                    if (stats != nullptr) {
+                        stats->stepped(x, y);
+                    }
+                    result.rotations += out != heading;
+                });
+            }
+            return false;
+        }
+
+        //! Clears the visit map and places the robot for a new episode, like the Restart state.
+        void restart(int start_x, int start_y, int start_heading) {
+            if (!seen->is_shared()) {
+                seen->reset_map(); // A shared map is still used by the other robots
+            }
+            if (recorder != nullptr) {
+                recorder->restarted();
+            }
+            start(start_x, start_y, start_heading);
+        }
+
+        //! Ends the current episode, counted as abandoned when the robot did not get out.
+        void finish() {
+            if (stats != nullptr && !result.exited) {
+                stats->episode_end(false); // Abandoned, like a restart before the exit
+            }
+        }
+
+        //! Plays one episode on a cleared visit map.
+        //! \param max_decisions (long) the episode is abandoned after this many decisions.
+        EpisodeResult run_episode(int start_x, int start_y, int start_heading, long max_decisions) {
+            restart(start_x, start_y, start_heading);
+            while (result.decisions < max_decisions && !step()) {
+            }
+            finish();
+            return result;
+        }
+
+        GridBody body;
+        SeenMap *seen;
+        MazeSolver *solver;
+        MazeExit maze_exit;
+        const CorridorMap *corridors;
+        uint64_t ties; //!< xorshift state of the tie breaks, 0 when they are not random
+        TrajectoryRecorder *recorder;
+        ExplorationPolicy *policy;
+        VisitStatsFeed *stats;
+        LookaheadPlanner *planner;
+        EpisodeResult result;
+    };
+
+    //! Plays one episode of every policy from the same start and keeps the one that got out in the fewest
+    //! steps, so the cheapest policy for the maze at hand is used. The race is run on a private visit map.
+    //! \param names (vector) the candidate policies, see policy_names().
+    //! \param max_decisions (long) a policy that needs more decisions does not finish the race.
+    //! \return the name of the winner, the first candidate when none got out.
+    inline std::string fastest_policy(const MazeGrid &grid, const std::vector<std::string> &names, int start_x, int start_y,
+                                      int start_heading, long max_decisions) {
+        SeenMap seen(grid.width(), grid.height());
+        std::string best = names.empty() ? "least_visited" : names[0];
+        long best_steps = -1;
+        for (auto &name : names) {
+            std::unique_ptr<ExplorationPolicy> policy = make_policy(name);
+            if (policy == nullptr) {
+                continue;
+            }
+            HeadlessWanderer racer(grid, seen);
+            racer.explore_with(policy.get());
+            EpisodeResult r = racer.run_episode(start_x, start_y, start_heading, max_decisions);
+            if (r.exited && (best_steps < 0 || r.steps < best_steps)) {
+                best = name;
+                best_steps = r.steps;
+            }
+        }
+        return best;
+    }
+
+    //! Statistics of a team of robots exploring the same maze.
+    struct TeamResult
+    {
+        bool exited;    //!< true when a robot left the maze before running out of decisions
+        long rounds;    //!< decisions made by the robot that left the maze (or the most active robot)
+        long decisions; //!< decisions made by the whole team
+    };
+
+    //! Plays the robots of a team one decision each per round, until one of them leaves the maze.
+    //! The robots must already be started, their visit maps are left alone.
+    //! \param team (vector) the robots, sharing one SeenMap or each with its own.
+    //! \param max_rounds (long) the team gives up after this many rounds.
+    inline TeamResult run_team(std::vector<HeadlessWanderer> &team, long max_rounds) {
+        TeamResult result = { false, 0, 0 };
+        while (!result.exited && result.rounds < max_rounds) {
+            result.rounds++;
+            for (auto &robot : team) {
+                result.decisions++;
+                if (robot.step()) {
+                    result.exited = true;
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+
+    //! Same as run_team() with the robots spread over several threads, each thread plays its robots as
+    //! fast as it can. Robots sharing a SeenMap only meet on its atomic counters and on the stop flag.
+    //! \param threads (int) number of threads.
+    inline TeamResult run_team_parallel(std::vector<HeadlessWanderer> &team, long max_rounds, int threads) {
+        std::atomic<bool> done(false);
+        std::vector<TeamResult> partial(threads, { false, 0, 0 });
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&, t]() {
+                TeamResult &mine = partial[t];
+                while (!done.load(std::memory_order_relaxed) && mine.rounds < max_rounds) {
+                    mine.rounds++;
+                    for (size_t i = t; i < team.size(); i += threads) {
+                        mine.decisions++;
+                        if (team[i].step()) {
+                            mine.exited = true;
+                            mine.rounds = team[i].result.decisions;
+                            done.store(true, std::memory_order_relaxed);
+                            break;
+                        }
+                    }
+                }
+            });
+        }
+        TeamResult result = { false, 0, 0 };
+        for (int t = 0; t < threads; t++) {
+            workers[t].join();
+            result.decisions += partial[t].decisions;
+            if (partial[t].exited && (!result.exited || partial[t].rounds < result.rounds)) {
+                result.exited = true;
+                result.rounds = partial[t].rounds;
+            } else if (!result.exited) {
+                result.rounds = std::max(result.rounds, partial[t].rounds);
+            }
+        }
+        return result;
+    }
+
+}
+
+#endif
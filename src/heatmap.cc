@@ -0,0 +1,6 @@
+#include <iostream>
+#include "heatmap.h"
+
+using namespace enviro;
+
+// Put your implementations here
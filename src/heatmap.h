@@ -0,0 +1,83 @@
+#ifndef __HEATMAP_AGENT__H
+#define __HEATMAP_AGENT__H
+
+#include <string>
+#include <iostream>
+#include <math.h>
+#include "enviro.h"
+#include <json/json.h>
+#include "maze_grid.h"
+#include "heatmap_stream.h"
+
+namespace
+{
+
+    using namespace enviro;
+
+    //! Draws the visit counts of the robots as an overlay, from the "heatmap" events of their HeatmapFeed.
+    //!
+    //! The messages of a frame are patched into the drawing as they arrive, and the drawing is handed to
+    //! enviro at most once per update, only when it changed. The drawing is in world coordinates, it is
+    //! moved back by the pose of the agent wherever config.json puts it. When it starts it emits
+    //! "heatmap_sync" so that the robots already running send their whole map.
+    class HeatmapController : public Process, public AgentInterface
+    {
+
+    public:
+        //! \param overlay (HeatmapOverlay) the drawing, in world coordinates.
+        HeatmapController(const HeatmapOverlay &overlay) : Process(), AgentInterface(), overlay(overlay) {}
+
+        void init() {
+            watch("heatmap", [&](Event &e) {
+                overlay.apply(e.value());
+            });
+        }
+        void start() {
+            emit(Event("heatmap_sync"));
+        }
+        void update() {
+            if (overlay.take_change()) {
+                decorate("<g transform='rotate(" + std::to_string(-angle() * 180.0 / M_PI) + ") translate("
+                         + std::to_string(-position().x) + "," + std::to_string(-position().y) + ")'>"
+                         + overlay.svg() + "</g>");
+            }
+        }
+        void stop() {}
+
+        HeatmapOverlay overlay;
+
+    };
+
+    class Heatmap : public Agent
+    {
+
+    public:
+        //! The blocks are laid out like the maze of config.json, the "heatmap" options give the colors.
+        Heatmap(json spec, World &world) : Agent(spec, world), hc(overlay(spec)) {
+            add_process(hc);
+        }
+
+        HeatmapController hc;
+
+    private:
+        static HeatmapOverlay overlay(const json &spec) {
+            json options = spec.value("heatmap", json::object());
+            double x = -350.0, y = -350.0, block = 100.0;
+            try {
+                MazeGrid grid = MazeGrid::load(options.value("grid", MazeGrid::grid_beside("config.json")));
+                x = grid.origin_x();
+                y = grid.origin_y();
+                block = grid.cell_size();
+            } catch (std::exception &e) {
+                std::cout << "Heatmap: " << e.what() << ", using the default maze layout" << std::endl;
+            }
+            return HeatmapOverlay(x, y, block, options.value("color", "orangered"), options.value("saturation", 8),
+                                  options.value("max_blocks", HeatmapOverlay::DEFAULT_MAX_BLOCKS));
+        }
+    };
+
+    DECLARE_INTERFACE(Heatmap);
+
+}
+
+#endif
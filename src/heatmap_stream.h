@@ -0,0 +1,285 @@
+#ifndef __HEATMAP_STREAM__H
+#define __HEATMAP_STREAM__H
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include <json/json.h>
+#include "seen_map.h"
+
+namespace
+{
+
+    //! Collects the blocks whose visit count changed, and turns them into at most one message per frame.
+    //!
+    //! The robot reports every block it marks as visited with touched(), the block is queued once however
+    //! many times it is touched before the next message. collect() then sends the current counts of the
+    //! queued blocks only, so a frame costs the same on a 7x7 maze as on a 2000x2000 one. The first
+    //! message, the one after a restart, and the one after snapshot() carry every visited block instead,
+    //! for an overlay that has just started or whose counts are stale.
+    //!
+    //! A message is a JSON object: { "agent": id, "width": w, "height": h, "full": bool, "cells": [i, v, ...] }
+    //! where i is the row-major index of a block and v its count. A full message replaces the counts of
+    //! the agent, a delta updates the listed blocks.
+    class HeatmapFeed
+    {
+    public:
+        //! \param agent (int) the id of the robot, the overlay keeps one layer per robot.
+        HeatmapFeed(int agent) : agent(agent), full(true) {}
+
+        //! Queues the block (x, y) for the next message.
+        void touched(int x, int y) {
+            size_t i = (size_t) y * width + x;
+            if ((unsigned) x >= (unsigned) width || (unsigned) y >= (unsigned) height || dirty[i]) {
+                return;
+            }
+            dirty[i] = 1;
+            queue.push_back((uint32_t) i);
+        }
+
+        //! The visit map was cleared, the next message is a full one.
+        void restarted() { full = true; }
+
+        //! Makes the next message a full one, for an overlay that has just started.
+        void snapshot() { full = true; }
+
+        //! Builds the message of this frame.
+        //! \param seen (SeenMap) the visit map the blocks were touched in.
+        //! \param message (json) receives the message.
+        //! \return false when nothing changed since the last message.
+        bool collect(const SeenMap &seen, nlohmann::json &message) {
+            if (seen.width() != width || seen.height() != height) {
+                width = seen.width();
+                height = seen.height();
+                dirty.assign((size_t) width * height, 0);
+                queue.clear();
+                full = true;
+            }
+            if (!full && queue.empty()) {
+                return false;
+            }
+            std::vector<int> cells;
+            if (full) {
+                for (int y = 0; y < height; y++) {
+                    for (int x = 0; x < width; x++) {
+                        if (int v = seen.get_value(x, y)) {
+                            cells.push_back(y * width + x);
+                            cells.push_back(v);
+                        }
+                    }
+                }
+            } else {
+                cells.reserve(queue.size() * 2);
+                for (uint32_t i : queue) {
+                    cells.push_back((int) i);
+                    cells.push_back(seen.get_value(i % width, i / width));
+                }
+            }
+            for (uint32_t i : queue) {
+                dirty[i] = 0;
+            }
+            queue.clear();
+            message = { { "agent", agent }, { "width", width }, { "height", height }, { "full", full }, { "cells", cells } };
+            full = false;
+            return true;
+        }
+
+    private:
+        int agent;
+        int width = 0;
+        int height = 0;
+        bool full;                          //!< the next message carries every visited block
+        std::vector<unsigned char> dirty;   //!< per block: already in the queue
+        std::vector<uint32_t> queue;        //!< blocks touched since the last message
+    };
+
+    //! The SVG of the heatmap, drawn from the messages of one or several HeatmapFeed.
+    //!
+    //! Only the visited blocks are drawn, each as one rect of fixed length whose opacity is the only part
+    //! that changes. A block is appended to the drawing the first time it is counted, and a message
+    //! patches the four opacity characters of the blocks it lists in place. A delta therefore costs the
+    //! number of blocks it lists, and the drawing, which enviro copies and sends whole on every change,
+    //! grows with the visited blocks, not with the maze. A full message clears the blocks of its robot,
+    //! the drawing is then rewritten from the blocks still counted. With several robots a block shows the
+    //! highest count of all. At most max_blocks blocks are drawn, the blocks counted past it are left out
+    //! so that a robot exploring a huge maze does not make every frame heavier.
+    class HeatmapOverlay
+    {
+    public:
+        //! \param x (double) left side of the maze in the coordinates of the drawing.
+        //! \param y (double) top side of the maze in the coordinates of the drawing.
+        //! \param block (double) the side of a block.
+        //! \param color (string) fill color of the visited blocks.
+        //! \param saturation (int) the count drawn at full opacity, the scale is logarithmic.
+        //! \param max_blocks (size_t) the most blocks drawn at once.
+        HeatmapOverlay(double x, double y, double block, const std::string &color, int saturation,
+                       size_t max_blocks = DEFAULT_MAX_BLOCKS)
+            : left(x), top(y), block(block), color(color), saturation(std::max(saturation, 1)),
+              max_blocks(max_blocks), width(0), height(0), pruned(false), changed(false) {}
+
+        //! 10000 blocks make a decoration of about 900 kB.
+        static constexpr size_t DEFAULT_MAX_BLOCKS = 10000;
+
+        //! Applies a HeatmapFeed message.
+        //! \return false when the message is malformed, nothing is changed then.
+        bool apply(const nlohmann::json &message) {
+            if (!message.is_object() || !message.contains("cells") || !message["cells"].is_array()) {
+                return false;
+            }
+            int w = message.value("width", 0), h = message.value("height", 0);
+            if (w <= 0 || h <= 0) {
+                return false;
+            }
+            if (w != width || h != height) {
+                layout(w, h);
+            }
+            int agent = message.value("agent", 0);
+            size_t layer = std::find(agents.begin(), agents.end(), agent) - agents.begin();
+            if (layer == agents.size()) {
+                agents.push_back(agent);
+                counts.emplace_back((size_t) width * height, 0);
+            }
+            std::vector<int> &values = counts[layer];
+            if (message.value("full", false)) {
+                for (size_t i = 0; i < values.size(); i++) {
+                    if (values[i] != 0) {
+                        values[i] = 0;
+                        refresh(i);
+                    }
+                }
+            }
+            const nlohmann::json &cells = message["cells"];
+            for (size_t k = 0; k + 1 < cells.size(); k += 2) {
+                if (!cells[k].is_number_integer() || !cells[k + 1].is_number_integer()) {
+                    continue;
+                }
+                long i = cells[k].get<long>();
+                if (i >= 0 && (size_t) i < values.size()) {
+                    values[i] = std::max(cells[k + 1].get<int>(), 0);
+                    refresh(i);
+                }
+            }
+            return true;
+        }
+
+        //! \return true once after the drawing changed.
+        bool take_change() {
+            if (pruned) {
+                prune();
+            }
+            bool c = changed;
+            changed = false;
+            return c;
+        }
+
+        //! \return the rects of the visited blocks, to be put in an SVG group.
+        const std::string &svg() const { return drawing; }
+
+        //! \return the number of blocks drawn.
+        size_t blocks() const { return drawn.size(); }
+
+    private:
+        static constexpr size_t OPACITY_CHARS = 4; // "0.00" to "1.00"
+        static constexpr size_t NOT_DRAWN = (size_t) -1;
+
+        void layout(int w, int h) {
+            width = w;
+            height = h;
+            agents.clear();
+            counts.clear();
+            shown.assign((size_t) w * h, 0);
+            opacity.assign((size_t) w * h, NOT_DRAWN);
+            drawn.clear();
+            drawing.clear();
+            pruned = false;
+            changed = true;
+        }
+
+        //! Draws the block i with the highest count of the layers.
+        void refresh(size_t i) {
+            int v = 0;
+            for (auto &layer : counts) {
+                v = std::max(v, layer[i]);
+            }
+            if (v == shown[i]) {
+                return;
+            }
+            shown[i] = v;
+            if (v == 0) {
+                pruned = pruned || opacity[i] != NOT_DRAWN; // Removed from the drawing at the end of the frame
+                changed = changed || pruned;
+                return;
+            }
+            if (opacity[i] == NOT_DRAWN) {
+                if (drawn.size() >= max_blocks) {
+                    return;
+                }
+                append(i);
+            }
+            changed = true;
+            char text[8];
+            std::snprintf(text, sizeof(text), "%.2f", level(v));
+            drawing.replace(opacity[i], OPACITY_CHARS, text, OPACITY_CHARS);
+        }
+
+        //! Appends the rect of block i to the drawing, with its opacity left to refresh().
+        void append(size_t i) {
+            char rect[256];
+            int n = std::snprintf(rect, sizeof(rect), "<rect x='%g' y='%g' width='%g' height='%g' fill='%s' fill-opacity='",
+                                  left + (i % width) * block, top + (i / width) * block, block, block, color.c_str());
+            opacity[i] = drawing.size() + n;
+            drawing.append(rect, n);
+            drawing += "0.00'/>";
+            drawn.push_back(i);
+        }
+
+        //! Rewrites the drawing without the blocks whose count went back to 0.
+        void prune() {
+            std::vector<size_t> kept;
+            kept.reserve(drawn.size());
+            for (size_t i : drawn) {
+                opacity[i] = NOT_DRAWN;
+                if (shown[i] > 0) { // The blocks left out stay out until their count changes
+                    kept.push_back(i);
+                }
+            }
+            drawn.clear();
+            drawing.clear();
+            for (size_t i : kept) {
+                append(i);
+                char text[8];
+                std::snprintf(text, sizeof(text), "%.2f", level(shown[i]));
+                drawing.replace(opacity[i], OPACITY_CHARS, text, OPACITY_CHARS);
+            }
+            pruned = false;
+        }
+
+        //! The opacity of a count, on a log scale.
+        double level(int v) const {
+            double l = std::min(1.0, std::log2(1.0 + v) / std::log2(1.0 + saturation));
+            return l * 0.8; // Keep the walls and the robot visible
+        }
+
+        double left;
+        double top;
+        double block;
+        std::string color;
+        int saturation;
+        size_t max_blocks;
+        int width;
+        int height;
+        std::vector<int> agents;                //!< the robots heard from, one layer each
+        std::vector<std::vector<int>> counts;   //!< per layer, the count of every block
+        std::vector<int> shown;                 //!< the count drawn for every block
+        std::vector<size_t> opacity;            //!< where the opacity of every block is in the drawing, NOT_DRAWN when it is not
+        std::vector<size_t> drawn;              //!< the blocks in the drawing, in drawing order
+        std::string drawing;
+        bool pruned;                            //!< a drawn block went back to 0
+        bool changed;
+    };
+}
+
+#endif
@@ -0,0 +1,305 @@
+#ifndef __MAZE_GEN__H
+#define __MAZE_GEN__H
+
+#include <vector>
+#include <string>
+#include <random>
+#include <ostream>
+#include <cstdint>
+#include "maze_grid.h"
+
+namespace
+{
+
+    //! Procedural maze generation on a MazeGrid.
+    //!
+    //! Every generator starts from a grid where all the edges are walls and carves a perfect maze (exactly
+    //! one route between any two blocks). braid() then removes dead ends to add loops, and open_exit()
+    //! opens the bottom edge of the bottom right block like in the original maze. The mazes use the same
+    //! layout as config.json: blocks of 100 with the top left corner at (-350, -350), so the robot starts
+    //! at (-300, -300) whatever the size.
+    class MazeGenerator
+    {
+    public:
+        typedef std::mt19937_64 Random;
+
+        //! \return a grid of width x height blocks with every edge closed.
+        static MazeGrid closed_grid(int width, int height) {
+            return MazeGrid(width, height, 100.0, -350.0, -350.0, 15);
+        }
+
+        //! Recursive backtracker (depth first search), with an explicit stack. Long winding corridors.
+        static void backtracker(MazeGrid &grid, Random &rng) {
+            int width = grid.width();
+            std::vector<bool> visited((size_t) width * grid.height(), false);
+            std::vector<uint32_t> stack = { 0 };
+            visited[0] = true;
+            while (!stack.empty()) {
+                uint32_t cell = stack.back();
+                int x = cell % width, y = cell / width;
+                int options[4], count = 0;
+                for (int h = 0; h < 4; h++) {
+                    int nx = x + MazeGrid::dx(h), ny = y + MazeGrid::dy(h);
+                    if (grid.in_bounds(nx, ny) && !visited[(size_t) ny * width + nx]) {
+                        options[count++] = h;
+                    }
+                }
+                if (count == 0) {
+                    stack.pop_back();
+                    continue;
+                }
+                int h = options[rng() % count];
+                int nx = x + MazeGrid::dx(h), ny = y + MazeGrid::dy(h);
+                grid.clear_wall_between(x, y, h);
+                visited[(size_t) ny * width + nx] = true;
+                stack.push_back(ny * width + nx);
+            }
+        }
+
+        //! Randomized Kruskal: remove walls in random order when they separate two unconnected regions.
+        //! Many short dead ends.
+        static void kruskal(MazeGrid &grid, Random &rng) {
+            int width = grid.width(), height = grid.height();
+            std::vector<uint32_t> parent((size_t) width * height);
+            for (size_t i = 0; i < parent.size(); i++) {
+                parent[i] = i;
+            }
+            // Edge e is the right (e even) or bottom (e odd) edge of block e / 2
+            std::vector<uint32_t> edges;
+            edges.reserve(parent.size() * 2);
+            for (int y = 0; y < height; y++) {
+                for (int x = 0; x < width; x++) {
+                    uint32_t cell = y * width + x;
+                    if (x + 1 < width) {
+                        edges.push_back(cell * 2);
+                    }
+                    if (y + 1 < height) {
+                        edges.push_back(cell * 2 + 1);
+                    }
+                }
+            }
+            for (size_t i = edges.size(); i > 1; i--) {
+                std::swap(edges[i - 1], edges[rng() % i]);
+            }
+            auto find = [&](uint32_t v) {
+                while (parent[v] != v) {
+                    parent[v] = parent[parent[v]]; // path halving
+                    v = parent[v];
+                }
+                return v;
+            };
+            for (uint32_t e : edges) {
+                uint32_t a = e / 2;
+                uint32_t b = e % 2 == 0 ? a + 1 : a + width;
+                uint32_t ra = find(a), rb = find(b);
+                if (ra != rb) {
+                    parent[ra] = rb;
+                    grid.clear_wall_between(a % width, a / width, e % 2 == 0 ? MazeGrid::RIGHT : MazeGrid::DOWN);
+                }
+            }
+        }
+
+        //! Wilson's algorithm: loop-erased random walks, a uniformly random spanning tree without the bias
+        //! of the other two generators. Slower on big grids since the first walks are long.
+        static void wilson(MazeGrid &grid, Random &rng) {
+            int width = grid.width();
+            size_t size = (size_t) width * grid.height();
+            std::vector<bool> in_tree(size, false);
+            std::vector<unsigned char> direction(size, 0); // last exit of every block on the current walk
+            in_tree[rng() % size] = true;
+            for (size_t start = 0; start < size; start++) {
+                if (in_tree[start]) {
+                    continue;
+                }
+                // Walk until the tree is hit, a revisited block simply overwrites its exit, which erases the loop
+                size_t cell = start;
+                while (!in_tree[cell]) {
+                    int x = cell % width, y = cell / width, h, nx, ny;
+                    do {
+                        h = rng() % 4;
+                        nx = x + MazeGrid::dx(h);
+                        ny = y + MazeGrid::dy(h);
+                    } while (!grid.in_bounds(nx, ny));
+                    direction[cell] = h;
+                    cell = (size_t) ny * width + nx;
+                }
+                // Carve the loop-erased walk into the tree
+                cell = start;
+                while (!in_tree[cell]) {
+                    int x = cell % width, y = cell / width, h = direction[cell];
+                    grid.clear_wall_between(x, y, h);
+                    in_tree[cell] = true;
+                    cell = (size_t) (y + MazeGrid::dy(h)) * width + x + MazeGrid::dx(h);
+                }
+            }
+        }
+
+        //! Removes dead ends to make a braided maze with loops.
+        //! \param probability (double) chance for every dead end to be opened, 1 removes them all.
+        static void braid(MazeGrid &grid, Random &rng, double probability) {
+            std::uniform_real_distribution<double> chance(0.0, 1.0);
+            for (int y = 0; y < grid.height(); y++) {
+                for (int x = 0; x < grid.width(); x++) {
+                    if (open_edges(grid, x, y) != 1 || chance(rng) >= probability) {
+                        continue;
+                    }
+                    // Prefer opening into another dead end, which removes both
+                    int best = -1;
+                    for (int h = 0; h < 4; h++) {
+                        int nx = x + MazeGrid::dx(h), ny = y + MazeGrid::dy(h);
+                        if (grid.is_open(x, y, h) || !grid.in_bounds(nx, ny)) {
+                            continue;
+                        }
+                        if (best < 0 || open_edges(grid, nx, ny) == 1) {
+                            best = h;
+                        }
+                    }
+                    if (best >= 0) {
+                        grid.clear_wall_between(x, y, best);
+                    }
+                }
+            }
+        }
+
+        //! Opens the bottom edge of the bottom right block.
+        static void open_exit(MazeGrid &grid) {
+            grid.clear_wall_between(grid.width() - 1, grid.height() - 1, MazeGrid::DOWN);
+        }
+
+        //! Generates a maze.
+        //! \param algorithm (string) "backtracker", "kruskal" or "wilson".
+        //! \param braiding (double) probability to remove every dead end, 0 for a perfect maze.
+        static MazeGrid generate(int width, int height, const std::string &algorithm, uint64_t seed, double braiding = 0.0) {
+            Random rng(seed);
+            MazeGrid grid = closed_grid(width, height);
+            if (algorithm == "kruskal") {
+                kruskal(grid, rng);
+            } else if (algorithm == "wilson") {
+                wilson(grid, rng);
+            } else {
+                backtracker(grid, rng);
+            }
+            if (braiding > 0) {
+                braid(grid, rng, braiding);
+            }
+            open_exit(grid);
+            return grid;
+        }
+
+        //! Streams a config.json for the maze, in the same layout as the original one: the buttons, the
+        //! heatmap overlay just outside the maze, the Wanderer at the top left block and the walls as
+        //! statics. The boundary is drawn with four thick polygons and collinear inner walls are merged
+        //! into one segment per run.
+        static void write_config(std::ostream &out, const MazeGrid &grid) {
+            double left = grid.origin_x(), top = grid.origin_y(), cell = grid.cell_size();
+            double right = left + grid.width() * cell, bottom = top + grid.height() * cell;
+            out << "{\n\n"
+                << "    \"name\": \"Maze\",\n"
+                << "    \"ip\": \"0.0.0.0\",\n"
+                << "    \"port\": 8765,\n\n"
+                << "    \"buttons\": [\n";
+            const char *buttons[4][2] = {
+                { "restart", "Restart" }, { "player", "Control Robot" }, { "selfWander", "Self Wander" }, { "solve", "Solve" }
+            };
+            for (int i = 0; i < 4; i++) {
+                out << "        {\n"
+                    << "            \"name\": \"" << buttons[i][0] << "\",\n"
+                    << "            \"label\": \"" << buttons[i][1] << "\",\n"
+                    << "            \"style\": { \"background\": \"white\", \"borderColor\": \"black\" }\n"
+                    << "        }" << (i < 3 ? ",\n" : "\n");
+            }
+            out << "    ],\n\n"
+                << "    \"agents\": [\n"
+                << "        {\n"
+                << "            \"definition\": \"defs/heatmap.json\",\n"
+                << "            \"style\": { \"fill\": \"none\", \"stroke\": \"none\" },\n"
+                << "            \"position\": {\n"
+                << "                \"x\": " << left - 20 << ",\n"
+                << "                \"y\": " << top - 20 << ",\n"
+                << "                \"theta\": 0\n"
+                << "            }\n"
+                << "        },\n"
+                << "        {\n"
+                << "            \"definition\": \"defs/wanderer.json\",\n"
+                << "            \"style\": { \"fill\": \"lightgreen\", \"stroke\": \"black\" },\n"
+                << "            \"position\": {\n"
+                << "                \"x\": " << grid.center_x(0) << ",\n"
+                << "                \"y\": " << grid.center_y(0) << ",\n"
+                << "                \"theta\": 0\n"
+                << "            }\n"
+                << "        }\n"
+                << "    ],\n\n"
+                << "    \"statics\": [\n";
+            bool first = true;
+            auto boundary = [&](double x1, double y1, double x2, double y2) {
+                out << (first ? "" : ",\n")
+                    << "        {\n"
+                    << "            \"style\": { \"fill\": \"gray\", \"stroke\": \"none\" },\n"
+                    << "            \"shape\": [\n"
+                    << "                { \"x\": " << x1 << ", \"y\": " << y1 << " },\n"
+                    << "                { \"x\": " << x1 << ", \"y\": " << y2 << " },\n"
+                    << "                { \"x\": " << x2 << ", \"y\": " << y2 << " },\n"
+                    << "                { \"x\": " << x2 << ", \"y\": " << y1 << " }\n"
+                    << "            ]\n"
+                    << "        }";
+                first = false;
+            };
+            auto wall = [&](double x1, double y1, double x2, double y2) {
+                // One line per wall, big mazes have millions of them
+                out << ",\n"
+                    << "        { \"style\": { \"fill\": \"none\", \"stroke\": \"gray\", \"stroke-width\": 5 }, \"shape\": [ "
+                    << "{ \"x\": " << x1 << ", \"y\": " << y1 << " }, { \"x\": " << x2 << ", \"y\": " << y2 << " } ] }";
+            };
+            // The outer walls, split around the openings of the bottom boundary
+            boundary(left, top, left + 10, bottom);
+            boundary(right - 10, top, right, bottom);
+            boundary(left, top, right, top + 10);
+            for (int x = 0; x < grid.width();) {
+                int end = x;
+                while (end < grid.width() && !grid.is_open(end, grid.height() - 1, MazeGrid::DOWN)) {
+                    end++;
+                }
+                if (end > x) {
+                    boundary(left + x * cell, bottom - 10, left + end * cell, bottom);
+                }
+                x = end + 1;
+            }
+            // Inner horizontal walls, one segment per run of closed bottom edges
+            for (int y = 0; y + 1 < grid.height(); y++) {
+                for (int x = 0; x < grid.width();) {
+                    int end = x;
+                    while (end < grid.width() && !grid.is_open(end, y, MazeGrid::DOWN)) {
+                        end++;
+                    }
+                    if (end > x) {
+                        wall(left + x * cell, top + (y + 1) * cell, left + end * cell, top + (y + 1) * cell);
+                    }
+                    x = end + 1;
+                }
+            }
+            // Inner vertical walls, one segment per run of closed right edges
+            for (int x = 0; x + 1 < grid.width(); x++) {
+                for (int y = 0; y < grid.height();) {
+                    int end = y;
+                    while (end < grid.height() && !grid.is_open(x, end, MazeGrid::RIGHT)) {
+                        end++;
+                    }
+                    if (end > y) {
+                        wall(left + (x + 1) * cell, top + y * cell, left + (x + 1) * cell, top + end * cell);
+                    }
+                    y = end + 1;
+                }
+            }
+            out << "\n    ]\n\n}\n";
+        }
+
+    private:
+        static int open_edges(const MazeGrid &grid, int x, int y) {
+            int walls = grid.wall_mask(x, y);
+            return 4 - ((walls & 1) + (walls >> 1 & 1) + (walls >> 2 & 1) + (walls >> 3 & 1));
+        }
+    };
+
+}
+
+#endif
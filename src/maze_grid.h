@@ -0,0 +1,304 @@
+#ifndef __MAZE_GRID__H
+#define __MAZE_GRID__H
+
+#include <string>
+#include <array>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include <math.h>
+#include <sys/stat.h>
+#include <json/json.h>
+
+namespace
+{
+
+    //! Column / row offsets of one step in each heading: right, down, left, up.
+    constexpr int DIRECTION_X[4] = { 1, 0, -1, 0 };
+    constexpr int DIRECTION_Y[4] = { 0, 1, 0, -1 };
+
+    //! Bits of the free space mask, set when there is no obstacle in that direction.
+    enum OpenSide { OPEN_FRONT = 1, OPEN_RIGHT = 2, OPEN_LEFT = 4 };
+
+    //! Converts a 4-bit wall mask seen with a heading into a free space mask of OpenSide bits.
+    constexpr int open_sides_of(int walls, int heading) {
+        return !(walls >> (heading & 3) & 1) * OPEN_FRONT
+             | !(walls >> ((heading + 1) & 3) & 1) * OPEN_RIGHT
+             | !(walls >> ((heading + 3) & 3) & 1) * OPEN_LEFT;
+    }
+
+    //! Free space masks for every wall mask and heading, indexed by walls * 4 + heading.
+    constexpr std::array<unsigned char, 16 * 4> make_open_sides_table() {
+        std::array<unsigned char, 16 * 4> table = {};
+        for (int walls = 0; walls < 16; walls++) {
+            for (int heading = 0; heading < 4; heading++) {
+                table[walls * 4 + heading] = open_sides_of(walls, heading);
+            }
+        }
+        return table;
+    }
+
+    constexpr std::array<unsigned char, 16 * 4> OPEN_SIDES_TABLE = make_open_sides_table();
+
+    //! A grid representation of the maze walls, built from the "statics" section of config.json.
+    //!
+    //! Every block keeps a 4-bit mask of its closed edges. Bit i is set when the edge in heading i is
+    //! a wall, headings are numbered in the order the robot's angle increases: right, down, left, up.
+    //! A wall between two blocks is stored in both of them.
+    class MazeGrid
+    {
+    public:
+        enum Heading { RIGHT = 0, DOWN = 1, LEFT = 2, UP = 3 };
+
+        MazeGrid() : grid_width(0), grid_height(0), cell(100.0), left(0.0), top(0.0) {}
+
+        //! Creates a grid where every block has the same wall mask, no walls at all by default.
+        //! \param width (int) number of columns.
+        //! \param height (int) number of rows.
+        //! \param cell_size (double) width of one block in world units.
+        //! \param origin_x (double) world x position of the left edge of the maze.
+        //! \param origin_y (double) world y position of the top edge of the maze.
+        //! \param fill (int) initial wall mask of every block, 15 closes every edge.
+        MazeGrid(int width, int height, double cell_size, double origin_x, double origin_y, int fill = 0)
+            : grid_width(width), grid_height(height), cell(cell_size), left(origin_x), top(origin_y),
+              walls((size_t) width * height, fill) {}
+
+        //! Rasterizes the wall polygons of a parsed config.json into a grid.
+        //! The maze size is taken from the bounding box of the statics.
+        //! \param config (json) the parsed config.json.
+        //! \param cell_size (double) width of one block in world units.
+        static MazeGrid from_config(const nlohmann::json &config, double cell_size = 100.0) {
+            const nlohmann::json &statics = config.at("statics");
+            double min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+            for (auto &s : statics) {
+                for (auto &p : s.at("shape")) {
+                    min_x = std::min(min_x, p.at("x").get<double>());
+                    min_y = std::min(min_y, p.at("y").get<double>());
+                    max_x = std::max(max_x, p.at("x").get<double>());
+                    max_y = std::max(max_y, p.at("y").get<double>());
+                }
+            }
+            if (statics.empty()) {
+                throw std::runtime_error("config has no statics to build the maze from");
+            }
+            MazeGrid grid((int) std::lround((max_x - min_x) / cell_size),
+                          (int) std::lround((max_y - min_y) / cell_size),
+                          cell_size, min_x, min_y);
+            for (auto &s : statics) {
+                const nlohmann::json &shape = s.at("shape");
+                int n = shape.size();
+                int edges = n > 2 ? n : n - 1; // polygons are closed, two point shapes are lines
+                for (int i = 0; i < edges; i++) {
+                    const nlohmann::json &a = shape[i];
+                    const nlohmann::json &b = shape[(i + 1) % n];
+                    grid.add_segment(a.at("x").get<double>(), a.at("y").get<double>(),
+                                     b.at("x").get<double>(), b.at("y").get<double>());
+                }
+            }
+            return grid;
+        }
+
+        //! Reads and rasterizes a config.json file, or reads a grid file written by save_grid() when the
+        //! path ends with ".grid".
+        //! \param path (string) path of the config or grid file.
+        static MazeGrid load(const std::string &path, double cell_size = 100.0) {
+            if (path.size() > 5 && path.compare(path.size() - 5, 5, ".grid") == 0) {
+                return load_grid(path);
+            }
+            std::ifstream in(path);
+            if (!in) {
+                throw std::runtime_error("could not open " + path);
+            }
+            nlohmann::json config;
+            in >> config;
+            return from_config(config, cell_size);
+        }
+
+        //! \return the grid file maze_gen writes next to a config file (maze.grid for maze.json) when it
+        //! exists and is not older than the config, the config itself otherwise.
+        //! \param config (string) path of the config file.
+        static std::string grid_beside(const std::string &config) {
+            size_t dot = config.find_last_of('.'), slash = config.find_last_of('/');
+            std::string path = (dot == std::string::npos || (slash != std::string::npos && dot < slash) ? config : config.substr(0, dot)) + ".grid";
+            struct stat grid_file, config_file;
+            if (stat(path.c_str(), &grid_file) != 0 || (stat(config.c_str(), &config_file) == 0 && grid_file.st_mtime < config_file.st_mtime)) {
+                return config; // A stale grid may be the walls of another maze
+            }
+            return path;
+        }
+
+        //! Writes the grid to a compact binary file: the "MZG1" magic, the width and height as 32-bit
+        //! integers, the cell size and origin as doubles, then the wall masks packed two blocks per byte
+        //! (the even block in the low nibble), in row-major order. Host byte order.
+        //! \param path (string) path of the grid file.
+        void save_grid(const std::string &path) const {
+            std::ofstream out(path, std::ios::binary);
+            if (!out) {
+                throw std::runtime_error("could not create " + path);
+            }
+            int32_t size[2] = { grid_width, grid_height };
+            double geometry[3] = { cell, left, top };
+            out.write(GRID_MAGIC, 4);
+            out.write((const char *) size, sizeof(size));
+            out.write((const char *) geometry, sizeof(geometry));
+            std::vector<char> packed((walls.size() + 1) / 2, 0);
+            for (size_t i = 0; i < walls.size(); i++) {
+                packed[i / 2] |= walls[i] << (i % 2 * 4);
+            }
+            out.write(packed.data(), packed.size());
+            if (!out) {
+                throw std::runtime_error("could not write " + path);
+            }
+        }
+
+        //! Reads a grid file written by save_grid().
+        //! \param path (string) path of the grid file.
+        static MazeGrid load_grid(const std::string &path) {
+            std::ifstream in(path, std::ios::binary);
+            if (!in) {
+                throw std::runtime_error("could not open " + path);
+            }
+            char magic[4];
+            int32_t size[2];
+            double geometry[3];
+            in.read(magic, 4);
+            in.read((char *) size, sizeof(size));
+            in.read((char *) geometry, sizeof(geometry));
+            if (!in || std::string(magic, 4) != GRID_MAGIC || size[0] <= 0 || size[1] <= 0) {
+                throw std::runtime_error(path + " is not a maze grid file");
+            }
+            MazeGrid grid(size[0], size[1], geometry[0], geometry[1], geometry[2]);
+            std::vector<char> packed((grid.walls.size() + 1) / 2);
+            in.read(packed.data(), packed.size());
+            if (!in) {
+                throw std::runtime_error(path + " is truncated");
+            }
+            for (size_t i = 0; i < grid.walls.size(); i++) {
+                grid.walls[i] = packed[i / 2] >> (i % 2 * 4) & 15;
+            }
+            return grid;
+        }
+
+        //! Marks every block edge covered by the axis-aligned segment (x1, y1) - (x2, y2) as a wall.
+        //! Segments that are not close to a grid line (e.g. the inner side of the thick boundary) are snapped
+        //! to the nearest line when they are within 15% of a block from it, and ignored otherwise.
+        void add_segment(double x1, double y1, double x2, double y2) {
+            double tolerance = 0.15 * cell;
+            if (std::fabs(y1 - y2) < 1e-6) {
+                int line = (int) std::lround((y1 - top) / cell);
+                if (std::fabs(y1 - (top + line * cell)) > tolerance) {
+                    return;
+                }
+                double lo = std::min(x1, x2), hi = std::max(x1, x2);
+                for (int x = 0; x < grid_width; x++) {
+                    double mid = center_x(x);
+                    if (mid > lo && mid < hi) {
+                        set_wall_between(x, line - 1, DOWN);
+                    }
+                }
+            } else if (std::fabs(x1 - x2) < 1e-6) {
+                int line = (int) std::lround((x1 - left) / cell);
+                if (std::fabs(x1 - (left + line * cell)) > tolerance) {
+                    return;
+                }
+                double lo = std::min(y1, y2), hi = std::max(y1, y2);
+                for (int y = 0; y < grid_height; y++) {
+                    double mid = center_y(y);
+                    if (mid > lo && mid < hi) {
+                        set_wall_between(line - 1, y, RIGHT);
+                    }
+                }
+            }
+        }
+
+        //! Closes the edge of block (x, y) in the given heading, and the matching edge of the neighbour.
+        //! Either block may lie outside the grid, in which case only the other one is updated.
+        void set_wall_between(int x, int y, int heading) {
+            if (in_bounds(x, y)) {
+                walls[index(x, y)] |= 1 << heading;
+            }
+            int nx = x + dx(heading), ny = y + dy(heading);
+            if (in_bounds(nx, ny)) {
+                walls[index(nx, ny)] |= 1 << ((heading + 2) & 3);
+            }
+        }
+
+        //! Opens the edge of block (x, y) in the given heading, and the matching edge of the neighbour.
+        void clear_wall_between(int x, int y, int heading) {
+            if (in_bounds(x, y)) {
+                walls[index(x, y)] &= ~(1 << heading);
+            }
+            int nx = x + dx(heading), ny = y + dy(heading);
+            if (in_bounds(nx, ny)) {
+                walls[index(nx, ny)] &= ~(1 << ((heading + 2) & 3));
+            }
+        }
+
+        //! \return true when the edge of block (x, y) in the given heading has no wall.
+        bool is_open(int x, int y, int heading) const {
+            return !(walls[index(x, y)] & (1 << (heading & 3)));
+        }
+
+        //! Answers "is the edge ahead / on the right / on the left open" for a robot in block (x, y)
+        //! facing the given heading, the grid equivalent of testing sensor_value(0..2) > 100.
+        //! \return a free space mask made of OpenSide bits.
+        int open_sides(int x, int y, int heading) const {
+            return OPEN_SIDES_TABLE[walls[index(x, y)] * 4 + (heading & 3)];
+        }
+
+        //! \return the 4-bit wall mask of block (x, y).
+        int wall_mask(int x, int y) const { return walls[index(x, y)]; }
+
+        bool in_bounds(int x, int y) const {
+            return x >= 0 && y >= 0 && x < grid_width && y < grid_height;
+        }
+
+        //! Searches the boundary for an open outer edge.
+        //! \return true when an exit was found, and stores its block and heading.
+        bool find_exit(int &x, int &y, int &heading) const {
+            for (int cy = 0; cy < grid_height; cy++) {
+                for (int cx = 0; cx < grid_width; cx++) {
+                    for (int h = 0; h < 4; h++) {
+                        if (is_open(cx, cy, h) && !in_bounds(cx + dx(h), cy + dy(h))) {
+                            x = cx; y = cy; heading = h;
+                            return true;
+                        }
+                    }
+                }
+            }
+            return false;
+        }
+
+        int width() const { return grid_width; }
+        int height() const { return grid_height; }
+        double cell_size() const { return cell; }
+        double origin_x() const { return left; }
+        double origin_y() const { return top; }
+
+        //! World position of the center of column x / row y.
+        double center_x(int x) const { return left + (x + 0.5) * cell; }
+        double center_y(int y) const { return top + (y + 0.5) * cell; }
+
+        //! Column / row offsets of one step in the given heading.
+        static int dx(int heading) { return DIRECTION_X[heading & 3]; }
+        static int dy(int heading) { return DIRECTION_Y[heading & 3]; }
+
+    private:
+        size_t index(int x, int y) const { return (size_t) y * grid_width + x; }
+
+        static constexpr const char *GRID_MAGIC = "MZG1";
+
+        int grid_width;
+        int grid_height;
+        double cell;
+        double left;
+        double top;
+        //! Row-major wall masks, one byte per block.
+        std::vector<unsigned char> walls;
+    };
+
+}
+
+#endif
@@ -0,0 +1,239 @@
+#ifndef __MAZE_SOLVER__H
+#define __MAZE_SOLVER__H
+
+#include <vector>
+#include <deque>
+#include <queue>
+#include <climits>
+#include "maze_grid.h"
+#include "wander_policy.h"
+
+namespace
+{
+
+    //! Keeps the distance (in blocks) from every block of a MazeGrid to the exit, and follows it to solve the maze.
+    //!
+    //! The field is computed by a breadth first search from the exit block the first time it is needed and cached.
+    //! Walls added or removed through the solver update the field incrementally: removing a wall only lowers
+    //! distances, so they are relaxed outward from the opened edge; adding a wall only invalidates the blocks whose
+    //! every shortest route went through that edge, and only those are searched again.
+    class MazeSolver
+    {
+    public:
+        //! Distance of the blocks that can not reach the exit.
+        static constexpr unsigned UNREACHABLE = UINT_MAX;
+
+        //! \param grid (MazeGrid) the maze to solve, wall changes must go through add_wall() / remove_wall().
+        MazeSolver(MazeGrid &grid) : grid(grid), solved(false), has_exit(false), exit_x(0), exit_y(0), exit_heading(0) {
+            has_exit = grid.find_exit(exit_x, exit_y, exit_heading);
+        }
+
+        //! \return true when the maze has an exit the field can lead to.
+        bool ready() const { return has_exit; }
+
+        int exit_column() const { return exit_x; }
+        int exit_row() const { return exit_y; }
+        int exit_direction() const { return exit_heading; }
+
+        //! \return the number of moves from block (x, y) to the exit block, or UNREACHABLE.
+        unsigned distance(int x, int y) {
+            if (!solved) {
+                solve();
+            }
+            return grid.in_bounds(x, y) ? field[index(x, y)] : UNREACHABLE;
+        }
+
+        //! Computes the whole distance field from scratch.
+        void solve() {
+            field.assign((size_t) grid.width() * grid.height(), UNREACHABLE);
+            solved = true;
+            if (!has_exit) {
+                return;
+            }
+            field[index(exit_x, exit_y)] = 0;
+            std::deque<int> open = { index(exit_x, exit_y) };
+            relax(open);
+        }
+
+        //! Opens the edge of block (x, y) in the given heading and lowers the distances it shortens.
+        void remove_wall(int x, int y, int heading) {
+            grid.clear_wall_between(x, y, heading);
+            if (!solved) {
+                return;
+            }
+            int nx = x + MazeGrid::dx(heading), ny = y + MazeGrid::dy(heading);
+            if (!grid.in_bounds(x, y) || !grid.in_bounds(nx, ny)) {
+                return;
+            }
+            std::deque<int> open;
+            int a = index(x, y), b = index(nx, ny);
+            if (field[a] != UNREACHABLE && field[a] + 1 < field[b]) {
+                field[b] = field[a] + 1;
+                open.push_back(b);
+            } else if (field[b] != UNREACHABLE && field[b] + 1 < field[a]) {
+                field[a] = field[b] + 1;
+                open.push_back(a);
+            }
+            relax(open);
+        }
+
+        //! Closes the edge of block (x, y) in the given heading and searches again the blocks that lost their route.
+        void add_wall(int x, int y, int heading) {
+            grid.set_wall_between(x, y, heading);
+            if (!solved) {
+                return;
+            }
+            int nx = x + MazeGrid::dx(heading), ny = y + MazeGrid::dy(heading);
+            if (!grid.in_bounds(x, y) || !grid.in_bounds(nx, ny)) {
+                return;
+            }
+            int a = index(x, y), b = index(nx, ny);
+            int far;
+            if (field[a] != UNREACHABLE && field[b] == field[a] + 1) {
+                far = b;
+            } else if (field[b] != UNREACHABLE && field[a] == field[b] + 1) {
+                far = a;
+            } else {
+                return; // The edge was on no shortest route
+            }
+            if (supported(far)) {
+                return;
+            }
+            // Collect the blocks that have no neighbour one block closer to the exit outside of the set.
+            // The blocks are visited by increasing distance, so a block's supports are settled when it is checked.
+            std::vector<int> lost = { far };
+            std::vector<bool> in_lost(field.size(), false);
+            in_lost[far] = true;
+            for (size_t i = 0; i < lost.size(); i++) {
+                int v = lost[i];
+                for (int h = 0; h < 4; h++) {
+                    int w = neighbour(v, h);
+                    if (w >= 0 && !in_lost[w] && field[w] == field[v] + 1 && !supported(w, in_lost)) {
+                        in_lost[w] = true;
+                        lost.push_back(w);
+                    }
+                }
+            }
+            // Search the lost blocks again, seeded from their neighbours that kept their distance
+            typedef std::pair<unsigned, int> Entry;
+            std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+            for (int v : lost) {
+                field[v] = UNREACHABLE;
+            }
+            for (int v : lost) {
+                for (int h = 0; h < 4; h++) {
+                    int w = neighbour(v, h);
+                    if (w >= 0 && !in_lost[w] && field[w] != UNREACHABLE && field[w] + 1 < field[v]) {
+                        field[v] = field[w] + 1;
+                    }
+                }
+                if (field[v] != UNREACHABLE) {
+                    open.push({ field[v], v });
+                }
+            }
+            while (!open.empty()) {
+                Entry e = open.top();
+                open.pop();
+                if (e.first != field[e.second]) {
+                    continue;
+                }
+                for (int h = 0; h < 4; h++) {
+                    int w = neighbour(e.second, h);
+                    if (w >= 0 && e.first + 1 < field[w]) {
+                        field[w] = e.first + 1;
+                        open.push({ field[w], w });
+                    }
+                }
+            }
+        }
+
+        //! Follows the distance field one decision at a time: move to the open neighbour closest to the exit,
+        //! rotating first when it is not ahead. From the exit block the robot faces the exit and moves out.
+        //! \param x (int) current column.
+        //! \param y (int) current row.
+        //! \param heading (int) current heading.
+        //! \param next (Decision) receives the decision.
+        //! \return false when the exit can not be reached from (x, y).
+        bool decide(int x, int y, int heading, Decision &next) {
+            unsigned d = distance(x, y);
+            if (d == UNREACHABLE) {
+                return false;
+            }
+            int goal = exit_heading;
+            if (d > 0) {
+                // Prefer going straight, then right, left and back
+                static const int preference[4] = { 0, 1, 3, 2 };
+                for (int i = 0; i < 4; i++) {
+                    int h = (heading + preference[i]) & 3;
+                    if (grid.is_open(x, y, h) && distance(x + MazeGrid::dx(h), y + MazeGrid::dy(h)) == d - 1) {
+                        goal = h;
+                        break;
+                    }
+                }
+            }
+            int turn = EXIT_TURN[(goal - heading) & 3];
+            next = turn == 0 ? Decision::move(x + MazeGrid::dx(goal), y + MazeGrid::dy(goal)) : Decision::rotate(turn);
+            return true;
+        }
+
+    private:
+        int index(int x, int y) const { return y * grid.width() + x; }
+
+        //! \return the index of the block next to v in heading h, or -1 when there is a wall.
+        int neighbour(int v, int h) const {
+            int x = v % grid.width(), y = v / grid.width();
+            if (!grid.is_open(x, y, h) || !grid.in_bounds(x + MazeGrid::dx(h), y + MazeGrid::dy(h))) {
+                return -1;
+            }
+            return index(x + MazeGrid::dx(h), y + MazeGrid::dy(h));
+        }
+
+        //! \return true when block v has an open neighbour one block closer to the exit.
+        bool supported(int v) const {
+            for (int h = 0; h < 4; h++) {
+                int w = neighbour(v, h);
+                if (w >= 0 && field[w] != UNREACHABLE && field[w] + 1 == field[v]) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        //! Same as supported(v), ignoring the neighbours that lost their route.
+        bool supported(int v, const std::vector<bool> &lost) const {
+            for (int h = 0; h < 4; h++) {
+                int w = neighbour(v, h);
+                if (w >= 0 && !lost[w] && field[w] != UNREACHABLE && field[w] + 1 == field[v]) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        //! Breadth first relaxation from the blocks in open, whose distances are already set.
+        void relax(std::deque<int> &open) {
+            while (!open.empty()) {
+                int v = open.front();
+                open.pop_front();
+                for (int h = 0; h < 4; h++) {
+                    int w = neighbour(v, h);
+                    if (w >= 0 && field[v] + 1 < field[w]) {
+                        field[w] = field[v] + 1;
+                        open.push_back(w);
+                    }
+                }
+            }
+        }
+
+        MazeGrid &grid;
+        std::vector<unsigned> field;
+        bool solved;
+        bool has_exit;
+        int exit_x;
+        int exit_y;
+        int exit_heading;
+    };
+
+}
+
+#endif
@@ -0,0 +1,386 @@
+#ifndef __PLANNER__H
+#define __PLANNER__H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include "maze_grid.h"
+#include "seen_map.h"
+#include "wander_policy.h"
+
+namespace
+{
+
+    //! A copy-on-write view of a SeenMap: reads fall through to the map, writes go to a small table of
+    //! the blocks touched since the view was made.
+    //!
+    //! Making a view or forking one copies only the touched blocks, never the map, so a rollout of a few
+    //! dozen steps costs the same on a 7x7 maze as on a 2000x2000 one. The table is an open-addressing
+    //! hash of the block indices, kept at most half full. The map must not change while views of it are
+    //! in use; several threads may read it through their own views.
+    class VisitSnapshot
+    {
+    public:
+        //! \param base (SeenMap) the map to read through, kept by reference.
+        //! \param capacity (int) blocks expected to be touched, the table grows past it.
+        VisitSnapshot(const SeenMap &base, int capacity = 32) : base(&base), entries(0) {
+            int size = 16;
+            while (size < 2 * capacity) {
+                size *= 2;
+            }
+            slots.assign(size, { EMPTY, 0 });
+            used.reserve(size / 2);
+        }
+
+        //! \param capacity (int) more blocks expected to be touched by the copy.
+        //! \return an independent copy of the view, in time proportional to the touched blocks.
+        VisitSnapshot fork(int capacity = 32) const {
+            VisitSnapshot copy(*base, (int) entries + capacity);
+            for (uint32_t i : used) {
+                copy.insert(slots[i].key, slots[i].count);
+            }
+            return copy;
+        }
+
+        //! Makes the view read like the map again, in time proportional to the touched blocks.
+        void clear() {
+            for (uint32_t i : used) {
+                slots[i].key = EMPTY;
+            }
+            used.clear();
+            entries = 0;
+        }
+
+        size_t touched() const { return entries; }
+        int width() const { return base->width(); }
+        int height() const { return base->height(); }
+
+        //! Like SeenMap::get_value().
+        int get_value(int x, int y) const {
+            if ((unsigned) x >= (unsigned) base->width() || (unsigned) y >= (unsigned) base->height()) {
+                return INT_MAX;
+            }
+            const Slot *slot = find(key(x, y));
+            return slot != nullptr ? slot->count : base->get_value(x, y);
+        }
+
+        //! Like SeenMap::neighbours().
+        void neighbours(int x, int y, int values[4]) const {
+            values[0] = get_value(x + 1, y);
+            values[1] = get_value(x, y + 1);
+            values[2] = get_value(x - 1, y);
+            values[3] = get_value(x, y - 1);
+        }
+
+        //! Like SeenMap::set_to_visited(), the map is left alone.
+        void set_to_visited(int x, int y) {
+            if ((unsigned) x >= (unsigned) base->width() || (unsigned) y >= (unsigned) base->height()) {
+                return;
+            }
+            uint32_t k = key(x, y);
+            Slot *slot = find(k);
+            if (slot == nullptr) {
+                if (2 * (entries + 1) > slots.size()) {
+                    grow();
+                }
+                slot = insert(k, base->get_value(x, y));
+            }
+            if (slot->count < COUNT_MAX) {
+                slot->count++;
+            }
+        }
+
+    private:
+        struct Slot
+        {
+            uint32_t key;
+            int count;
+        };
+
+        static constexpr uint32_t EMPTY = 0;
+        static constexpr int COUNT_MAX = 0xffff; // Saturates like the SeenMap
+
+        uint32_t key(int x, int y) const { return (uint32_t) y * base->width() + x + 1; }
+
+        const Slot *find(uint32_t k) const { return const_cast<VisitSnapshot *>(this)->find(k); }
+        Slot *find(uint32_t k) {
+            size_t mask = slots.size() - 1;
+            for (size_t i = hash(k) & mask;; i = (i + 1) & mask) {
+                if (slots[i].key == k) {
+                    return &slots[i];
+                } else if (slots[i].key == EMPTY) {
+                    return nullptr;
+                }
+            }
+        }
+
+        Slot *insert(uint32_t k, int count) {
+            size_t mask = slots.size() - 1, i = hash(k) & mask;
+            while (slots[i].key != EMPTY) {
+                i = (i + 1) & mask;
+            }
+            slots[i] = { k, count };
+            used.push_back((uint32_t) i);
+            entries++;
+            return &slots[i];
+        }
+
+        void grow() {
+            std::vector<Slot> old;
+            old.swap(slots);
+            slots.assign(old.size() * 2, { EMPTY, 0 });
+            used.clear();
+            entries = 0;
+            for (const Slot &s : old) {
+                if (s.key != EMPTY) {
+                    insert(s.key, s.count);
+                }
+            }
+        }
+
+        static size_t hash(uint32_t k) { return (size_t) (k * 0x9E3779B1u) >> 7; }
+
+        const SeenMap *base;
+        std::vector<Slot> slots;
+        std::vector<uint32_t> used;     //!< occupied slots, to clear in time proportional to them
+        size_t entries;
+    };
+
+    //! A fixed set of threads that run the jobs of one batch, the calling thread taking part.
+    class RolloutPool
+    {
+    public:
+        //! \param threads (int) threads running the jobs, the calling one included.
+        RolloutPool(int threads) : batch(0), jobs(0), next(0), pending(0), stopping(false) {
+            for (int t = 1; t < threads; t++) {
+                workers.emplace_back([this, t]() { work(t); });
+            }
+        }
+
+        ~RolloutPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (auto &w : workers) {
+                w.join();
+            }
+        }
+
+        int threads() const { return (int) workers.size() + 1; }
+
+        //! Runs job(i, thread) for every i below n and returns when they are all done.
+        void run(size_t n, const std::function<void(size_t, int)> &job) {
+            if (workers.empty() || n <= 1) {
+                for (size_t i = 0; i < n; i++) {
+                    job(i, 0);
+                }
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                current = &job;
+                jobs = n;
+                next.store(0, std::memory_order_relaxed);
+                pending = workers.size();
+                batch++;
+            }
+            wake.notify_all();
+            take(job, 0);
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this]() { return pending == 0; });
+        }
+
+    private:
+        void take(const std::function<void(size_t, int)> &job, int thread) {
+            for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < jobs; i = next.fetch_add(1, std::memory_order_relaxed)) {
+                job(i, thread);
+            }
+        }
+
+        void work(int thread) {
+            long seen_batch = 0;
+            while (true) {
+                const std::function<void(size_t, int)> *job;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&]() { return stopping || batch != seen_batch; });
+                    if (stopping) {
+                        return;
+                    }
+                    seen_batch = batch;
+                    job = current;
+                }
+                take(*job, thread);
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--pending == 0) {
+                    done.notify_one();
+                }
+            }
+        }
+
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        const std::function<void(size_t, int)> *current = nullptr;
+        long batch;
+        size_t jobs;
+        std::atomic<size_t> next;
+        size_t pending;
+        bool stopping;
+    };
+
+    //! Plans the next move of a wandering robot by playing the least visited rule ahead.
+    //!
+    //! For every way out of the current block, the robot is moved there on a VisitSnapshot of its visit
+    //! map, then rollouts of the least visited rule run for depth decisions on forks of that snapshot,
+    //! the first with the ties broken front first like the robot, the others at random. A rollout scores
+    //! the never visited blocks it enters, more the sooner, and far more for getting out of the maze. The
+    //! way with the best total is committed: the robot turns towards it without planning again, then
+    //! moves. The rollouts are spread over the threads of a RolloutPool. Neither the visit map nor the
+    //! robot is changed by planning, and a block with a single way out is not planned at all.
+    class LookaheadPlanner
+    {
+    public:
+        //! \param grid (MazeGrid) the walls to plan with, kept by reference.
+        //! \param depth (int) decisions played by each rollout.
+        //! \param rollouts (int) rollouts for each way out, at least 1.
+        //! \param threads (int) threads running the rollouts, the calling one included.
+        LookaheadPlanner(const MazeGrid &grid, int depth = 32, int rollouts = 4, int threads = 1)
+            : grid(grid), maze_exit(MazeExit::of(grid)), depth(std::max(1, depth)), rollouts(std::max(1, rollouts)),
+              pool(std::max(1, threads)), committed(-1), planned(0), played(0) {}
+
+        //! Forgets the committed way, called when the robot restarts.
+        void reset() { committed = -1; }
+
+        //! \param pose (GridPose) the block and heading of the robot.
+        //! \param seen (SeenMap) the visit map of the robot, only read.
+        //! \return a move to the block ahead or a quarter turn towards the planned way.
+        Decision decide(const GridPose &pose, const SeenMap &seen) {
+            if (pose.x == maze_exit.x && pose.y == maze_exit.y) {
+                committed = -1;
+                return wander_decision(grid, pose, seen, maze_exit); // Face the opening and leave
+            }
+            if (committed < 0 || committed_x != pose.x || committed_y != pose.y) {
+                committed = plan(pose, seen);
+                committed_x = pose.x;
+                committed_y = pose.y;
+            }
+            int turn = (committed - pose.heading) & 3;
+            if (turn == 0) {
+                committed = -1;
+                return Decision::move(pose.x + MazeGrid::dx(pose.heading), pose.y + MazeGrid::dy(pose.heading));
+            }
+            return Decision::rotate(turn == 3 ? -1 : 1); // Turning around goes clockwise, like a dead end
+        }
+
+        //! \return the blocks where the ways out were compared.
+        long plans() const { return planned; }
+        //! \return the rollouts played so far.
+        long rollouts_played() const { return played; }
+
+    private:
+        //! \return the heading of the best way out of the block of the robot.
+        int plan(const GridPose &pose, const SeenMap &seen) {
+            static const int turns[4] = { 0, 1, 3, 2 }; // Front, right, left, then back
+            int ways[4], count = 0;
+            for (int t : turns) {
+                int h = (pose.heading + t) & 3;
+                if (grid.is_open(pose.x, pose.y, h) && (t != 2 || count == 0)) {
+                    ways[count++] = h; // Back only in a dead end
+                }
+            }
+            if (count <= 1) {
+                return count == 1 ? ways[0] : (pose.heading + 2) & 3;
+            }
+            planned++;
+            std::vector<VisitSnapshot> starts;
+            for (int i = 0; i < count; i++) {
+                starts.emplace_back(seen, depth + 1);
+                starts.back().set_to_visited(pose.x, pose.y); // Like Moving::entry, the block being left
+            }
+            std::vector<long> scores(count * rollouts, 0);
+            pool.run(scores.size(), [&](size_t job, int) {
+                int way = (int) (job / rollouts), r = (int) (job % rollouts);
+                VisitSnapshot snapshot = starts[way].fork(depth);
+                GridPose at = { pose.x + MazeGrid::dx(ways[way]), pose.y + MazeGrid::dy(ways[way]), ways[way], true };
+                scores[job] = rollout(snapshot, at, r == 0 ? 0 : (uint64_t) (r * 0x9E3779B97F4A7C15ull) | 1);
+            });
+            played += scores.size();
+            // Ties go to the way the least visited rule takes, so the robot wanders like it where the
+            // rollouts find nothing new
+            Decision greedy = wander_decision(grid, pose, seen, maze_exit);
+            int best = greedy.kind == Decision::MOVE ? pose.heading : (pose.heading + greedy.rate) & 3;
+            long best_score = LONG_MIN;
+            for (int i = 0; i < count; i++) {
+                if (ways[i] == best) {
+                    best_score = total(scores, i);
+                }
+            }
+            for (int i = 0; i < count; i++) {
+                if (total(scores, i) > best_score) {
+                    best_score = total(scores, i);
+                    best = ways[i];
+                }
+            }
+            return best;
+        }
+
+        //! \return the sum of the scores of the rollouts of a way.
+        long total(const std::vector<long> &scores, int way) const {
+            long sum = 0;
+            for (int r = 0; r < rollouts; r++) {
+                sum += scores[way * rollouts + r];
+            }
+            return sum;
+        }
+
+        //! Plays the least visited rule from a pose on a snapshot.
+        //! \param ties (uint64_t) tie break state, 0 to break them front first, then right.
+        //! \return the score of the rollout.
+        long rollout(VisitSnapshot &snapshot, GridPose pose, uint64_t ties) const {
+            long score = seen_score(snapshot, pose.x, pose.y, 0);
+            for (int t = 1; t <= depth; t++) {
+                Decision d = wander_decision(grid, pose, snapshot, maze_exit, ties != 0 ? &ties : nullptr);
+                if (d.kind == Decision::ROTATE) {
+                    pose.rotate(d.rate);
+                    continue;
+                }
+                snapshot.set_to_visited(pose.x, pose.y);
+                if (!grid.in_bounds(d.x, d.y)) {
+                    return score + (long) (depth - t + 1) * depth * 4; // Out of the maze
+                }
+                pose.x = d.x;
+                pose.y = d.y;
+                score += seen_score(snapshot, pose.x, pose.y, t);
+            }
+            return score;
+        }
+
+        //! \return what entering block (x, y) after t decisions is worth.
+        long seen_score(const VisitSnapshot &snapshot, int x, int y, int t) const {
+            return snapshot.get_value(x, y) == 0 ? depth - t + 1 : 0;
+        }
+
+        const MazeGrid &grid;
+        MazeExit maze_exit;
+        int depth;
+        int rollouts;
+        RolloutPool pool;
+        int committed;      //!< heading the robot turns to before moving, -1 when none
+        int committed_x;
+        int committed_y;
+        long planned;
+        long played;
+    };
+
+}
+
+#endif
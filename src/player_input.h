@@ -0,0 +1,164 @@
+#ifndef __PLAYER_INPUT__H
+#define __PLAYER_INPUT__H
+
+#include <array>
+#include <string>
+#include <chrono>
+#include <algorithm>
+
+namespace
+{
+
+    //! Counters of the player's keyboard input, see PlayerInput.
+    struct InputStats
+    {
+        //! Latencies are binned by powers of two like the during() ones, bucket i counts [2^(i-1), 2^i) ns.
+        static constexpr int BUCKETS = 32;
+
+        long events = 0;    //!< key events received while driving
+        long repeats = 0;   //!< events that changed nothing: auto-repeats, or releases of keys not held
+        long commands = 0;  //!< new velocity commands applied to the robot
+        long coalesced = 0; //!< key changes merged into the command of the same tick, or undone in it
+        long max_ns = 0;    //!< the longest input-to-motion latency
+        std::array<long, BUCKETS> latency{}; //!< histogram of the input-to-motion latencies
+
+        //! \return the upper bound of the bucket holding the given fraction of the latencies, in ns.
+        long percentile(double p) const {
+            long total = 0, seen = 0;
+            for (long n : latency) {
+                total += n;
+            }
+            for (int i = 0; i < BUCKETS && total > 0; i++) {
+                seen += latency[i];
+                if (seen >= p * total) {
+                    return i == 0 ? 0 : std::min(1L << i, max_ns);
+                }
+            }
+            return 0;
+        }
+    };
+
+    //! Merges the keys held by the player into one velocity command per tick.
+    //!
+    //! The keydown and keyup events only update which keys are held, nothing is sent to the state
+    //! machine, so the auto-repeat of the browser costs a key lookup. Inplay reads the command once per
+    //! tick with apply(). On each axis the key pressed last among the held ones wins: releasing W while
+    //! S is still held backs up.
+    //!
+    //! The latency of a command is the time from the first key event that changed it to the apply() that
+    //! hands it to track_velocity().
+    class PlayerInput
+    {
+    public:
+        typedef std::chrono::steady_clock::time_point time_point;
+
+        //! \param velocity (double) speed while W or S is held.
+        //! \param omega (double) angular velocity while A or D is held.
+        PlayerInput(double velocity = 5, double omega = 0.5)
+            : max_velocity(velocity), max_omega(omega), order(0), velocity(0), omega(0),
+              applied_velocity(0), applied_omega(0), pending(false) {
+            held.fill(0);
+        }
+
+        //! A key was pressed, auto-repeats of a held key are dropped.
+        //! \return false when the key does not drive the robot.
+        bool press(const std::string &key, time_point now = std::chrono::steady_clock::now()) {
+            int k = index(key);
+            if (k < 0) {
+                return false;
+            }
+            stats.events++;
+            if (held[k] != 0) {
+                stats.repeats++;
+                return true;
+            }
+            held[k] = ++order;
+            changed(now);
+            return true;
+        }
+
+        //! A key was released.
+        //! \return false when the key does not drive the robot.
+        bool release(const std::string &key, time_point now = std::chrono::steady_clock::now()) {
+            int k = index(key);
+            if (k < 0) {
+                return false;
+            }
+            stats.events++;
+            if (held[k] == 0) {
+                stats.repeats++;
+                return true;
+            }
+            held[k] = 0;
+            changed(now);
+            return true;
+        }
+
+        //! Gives the command of this tick, called right before track_velocity().
+        //! \param v (double) receives the velocity.
+        //! \param av (double) receives the angular velocity.
+        void apply(double &v, double &av, time_point now = std::chrono::steady_clock::now()) {
+            if (pending) {
+                pending = false;
+                stats.commands++;
+                long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - since).count();
+                int bucket = ns <= 0 ? 0 : 64 - __builtin_clzll(ns);
+                stats.latency[bucket < InputStats::BUCKETS ? bucket : InputStats::BUCKETS - 1]++;
+                stats.max_ns = std::max(stats.max_ns, ns);
+            }
+            v = applied_velocity = velocity;
+            av = applied_omega = omega;
+        }
+
+        //! Releases every key, e.g. when the player gives the robot back.
+        void clear() {
+            held.fill(0);
+            velocity = omega = applied_velocity = applied_omega = 0;
+            pending = false;
+        }
+
+        const InputStats &statistics() const { return stats; }
+
+    private:
+        enum Key { W, S, A, D };
+
+        static int index(const std::string &key) {
+            return key == "w" ? W : key == "s" ? S : key == "a" ? A : key == "d" ? D : -1;
+        }
+
+        //! Recomputes the command after a key change.
+        void changed(time_point now) {
+            double v = held[W] == 0 && held[S] == 0 ? 0 : held[W] > held[S] ? max_velocity : -max_velocity;
+            double av = held[A] == 0 && held[D] == 0 ? 0 : held[D] > held[A] ? max_omega : -max_omega;
+            if (v == velocity && av == omega) {
+                return; // e.g. A released while D is held, D was pressed last
+            }
+            if (pending) {
+                stats.coalesced++; // The robot has not seen the previous change yet
+            }
+            velocity = v;
+            omega = av;
+            if (velocity == applied_velocity && omega == applied_omega) {
+                pending = false; // Undone before the robot saw it
+            } else if (!pending) {
+                pending = true;
+                since = now;
+            }
+        }
+
+        double max_velocity;
+        double max_omega;
+        std::array<long, 4> held; //!< per key, the order it was pressed in, 0 when released
+        long order;
+        double velocity;    //!< the command of the held keys
+        double omega;
+        double applied_velocity; //!< the command of the last apply()
+        double applied_omega;
+        bool pending;       //!< the command changed since the last apply()
+        time_point since;   //!< the first change since the last apply()
+        InputStats stats;
+    };
+
+}
+
+#endif
@@ -0,0 +1,228 @@
+#ifndef __POLICIES__H
+#define __POLICIES__H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "seen_map.h"
+#include "maze_grid.h"
+#include "wander_policy.h"
+#include "visit_stats.h"
+
+namespace
+{
+
+    //! A strategy for the Checking state: where to go next from the robot's grid pose.
+    //!
+    //! A policy only sees what the robot senses, the free space ahead, on the right and on the left, plus
+    //! the visit map. It may keep its own state between decisions, but never more than a few bytes per
+    //! block. The exit block is handled before the policy is asked, see explore_decision().
+    class ExplorationPolicy
+    {
+    public:
+        virtual ~ExplorationPolicy() {}
+
+        //! \param pose (GridPose) the block and heading of the robot.
+        //! \param open (int) free space mask made of OpenSide bits.
+        //! \param seen (SeenMap) the visit counts, also gives the size of the maze.
+        //! \return a move to the block ahead or a quarter turn.
+        virtual Decision decide(const GridPose &pose, int open, const SeenMap &seen) = 0;
+
+        //! Forgets the episode, called when the robot restarts.
+        virtual void reset() {}
+
+        //! Lets the policy use what was learned in the past episodes, ignored by default.
+        //! \param stats (VisitStats) the statistics of every episode so far, null to stop using them.
+        virtual void use_prior(const VisitStats *stats) {}
+
+        //! \return true when going through a corridor without deciding is what the policy would do anyway,
+        //! so the fast forward mode can be used with it.
+        virtual bool follows_corridors() const { return false; }
+
+        virtual const char *name() const = 0;
+    };
+
+    //! The original rule: the least visited block among the one ahead, on the right and on the left,
+    //! ties go to the front, then to the right. The same decision as wander_decision().
+    //!
+    //! With a prior, a block where a past episode hit a dead end reads as visited more than any other
+    //! block, so the robot only goes in when every other way is a known dead end too.
+    class LeastVisitedPolicy : public ExplorationPolicy
+    {
+    public:
+        //! Added to the count of a known dead end, more than a SeenMap counter can hold.
+        static constexpr int DEAD_END_PENALTY = 1 << 16;
+
+        LeastVisitedPolicy() : prior(nullptr) {}
+
+        Decision decide(const GridPose &pose, int open, const SeenMap &seen) {
+            int counts[4];
+            seen.neighbours(pose.x, pose.y, counts);
+            if (prior != nullptr) {
+                for (int h = 0; h < 4; h++) {
+                    if (counts[h] != INT_MAX && prior->dead_ends(pose.x + MazeGrid::dx(h), pose.y + MazeGrid::dy(h)) > 0) {
+                        counts[h] += DEAD_END_PENALTY;
+                    }
+                }
+            }
+            return ::decide(pose.x, pose.y, pose.heading, open, counts);
+        }
+        void use_prior(const VisitStats *stats) { prior = stats; }
+        bool follows_corridors() const { return true; }
+        const char *name() const { return "least_visited"; }
+
+    private:
+        const VisitStats *prior;
+    };
+
+    //! Keeps the right hand on the wall. Never uses the visit map and always gets out of a perfect maze,
+    //! but can circle forever around an island of a braided maze when it does not start on the outer wall.
+    class WallFollowerPolicy : public ExplorationPolicy
+    {
+    public:
+        WallFollowerPolicy() : turned_right(false) {}
+
+        Decision decide(const GridPose &pose, int open, const SeenMap &seen) {
+            if ((open & OPEN_RIGHT) && !turned_right) {
+                turned_right = true; // Then go through, the new right is where the robot came from
+                return Decision::rotate(1);
+            }
+            turned_right = false;
+            if (open & OPEN_FRONT) {
+                return Decision::move(pose.x + MazeGrid::dx(pose.heading), pose.y + MazeGrid::dy(pose.heading));
+            }
+            return Decision::rotate(-1);
+        }
+        void reset() { turned_right = false; }
+        bool follows_corridors() const { return true; }
+        const char *name() const { return "wall_follower"; }
+
+    private:
+        bool turned_right;
+    };
+
+    //! Trémaux's algorithm as a depth first search: go into a block never entered before, and when there
+    //! is none left around, go back the way the block was entered. Every passage is walked at most twice,
+    //! so the robot gets out after less than two moves per block, loops or not.
+    //!
+    //! The state is one byte per block (the headings already tried and two flags) and the backtrack
+    //! stack, one heading per entered block. When the robot is found somewhere the search did not take it
+    //! (the player drove it, or the solver did), the search starts again from there.
+    class TremauxPolicy : public ExplorationPolicy
+    {
+    public:
+        TremauxPolicy() : width(0), height(0), expected_x(0), expected_y(0), started(false) {}
+
+        Decision decide(const GridPose &pose, int open, const SeenMap &seen) {
+            if (!started || pose.x != expected_x || pose.y != expected_y || seen.width() != width || seen.height() != height) {
+                restart(pose, seen);
+            }
+            int heading = pose.heading;
+            unsigned char &block = cells[index(pose.x, pose.y)];
+            // Front, right and left are sensed, behind is only unknown at the root of the search
+            static const int turns[3] = { 0, 1, 3 };
+            static const int sides[3] = { OPEN_FRONT, OPEN_RIGHT, OPEN_LEFT };
+            for (int i = 0; i < 3; i++) {
+                int h = (heading + turns[i]) & 3;
+                if (!(open & sides[i]) || (block & tried(h))) {
+                    continue;
+                }
+                int nx = pose.x + MazeGrid::dx(h), ny = pose.y + MazeGrid::dy(h);
+                if (nx < 0 || ny < 0 || nx >= width || ny >= height || (cells[index(nx, ny)] & ENTERED)) {
+                    block |= tried(h); // Leads out of the maze or to a block already searched
+                    continue;
+                }
+                if (i > 0) {
+                    return Decision::rotate(turns[i] == 1 ? 1 : -1);
+                }
+                block |= tried(h);
+                cells[index(nx, ny)] |= ENTERED;
+                stack.push_back(h);
+                return move_to(nx, ny);
+            }
+            if (stack.empty() && !(block & LOOKED_BACK)) {
+                block |= LOOKED_BACK; // Root: turn to sense what was behind on the right
+                return Decision::rotate(1);
+            }
+            if (stack.empty()) {
+                return Decision::rotate(1); // Searched everything without finding the exit
+            }
+            int home = (stack.back() + 2) & 3;
+            if (home != heading) {
+                return Decision::rotate(((home - heading) & 3) == 3 ? -1 : 1);
+            }
+            stack.pop_back();
+            return move_to(pose.x + MazeGrid::dx(home), pose.y + MazeGrid::dy(home));
+        }
+
+        void reset() { started = false; }
+        const char *name() const { return "tremaux"; }
+
+    private:
+        enum { ENTERED = 0x10, LOOKED_BACK = 0x20 };
+        static int tried(int heading) { return 1 << heading; }
+        size_t index(int x, int y) const { return (size_t) y * width + x; }
+
+        Decision move_to(int x, int y) {
+            expected_x = x;
+            expected_y = y;
+            return Decision::move(x, y);
+        }
+
+        void restart(const GridPose &pose, const SeenMap &seen) {
+            width = seen.width();
+            height = seen.height();
+            cells.assign((size_t) width * height, 0);
+            stack.clear();
+            cells[index(pose.x, pose.y)] = ENTERED;
+            expected_x = pose.x;
+            expected_y = pose.y;
+            started = true;
+        }
+
+        std::vector<unsigned char> cells; //!< per block: one tried bit per heading, ENTERED and LOOKED_BACK
+        std::vector<unsigned char> stack; //!< the heading each block of the current path was entered with
+        int width;
+        int height;
+        int expected_x;
+        int expected_y;
+        bool started;
+    };
+
+    //! The names accepted by make_policy().
+    const std::vector<std::string> &policy_names() {
+        static const std::vector<std::string> names = { "least_visited", "wall_follower", "tremaux" };
+        return names;
+    }
+
+    //! \return a new policy, or null when the name is unknown.
+    std::unique_ptr<ExplorationPolicy> make_policy(const std::string &name) {
+        if (name == "least_visited") {
+            return std::unique_ptr<ExplorationPolicy>(new LeastVisitedPolicy());
+        } else if (name == "wall_follower") {
+            return std::unique_ptr<ExplorationPolicy>(new WallFollowerPolicy());
+        } else if (name == "tremaux") {
+            return std::unique_ptr<ExplorationPolicy>(new TremauxPolicy());
+        }
+        return nullptr;
+    }
+
+    //! Checking with a pluggable policy: at the exit block face the opening and move out, anywhere
+    //! else ask the policy.
+    //! \param body anything that provides open_sides(x, y, heading) returning OpenSide bits
+    template <class Body>
+    Decision explore_decision(Body &body, const GridPose &pose, const SeenMap &seen, const MazeExit &exit,
+                              ExplorationPolicy &policy)
+    {
+        if (pose.x == exit.x && pose.y == exit.y) {
+            int turn = EXIT_TURN[(exit.heading - pose.heading) & 3];
+            return turn == 0 ? Decision::move(pose.x + MazeGrid::dx(exit.heading), pose.y + MazeGrid::dy(exit.heading))
+                             : Decision::rotate(turn);
+        }
+        return policy.decide(pose, body.open_sides(pose.x, pose.y, pose.heading), seen);
+    }
+
+}
+
+#endif
@@ -0,0 +1,196 @@
+#ifndef __SCHEDULER__H
+#define __SCHEDULER__H
+
+#include <vector>
+#include <cstdint>
+#include "headless.h"
+
+namespace
+{
+
+    //! What a suspended WandererTask waits for before it can go on.
+    struct Suspension
+    {
+        enum Kind { ARRIVED, TURNED, INPUT };
+
+        //! Wait until the robot is in the next block, ticks from now.
+        static Suspension arrived(long ticks) { return { ARRIVED, ticks }; }
+        //! Wait until the quarter turn is done, ticks from now.
+        static Suspension turned(long ticks) { return { TURNED, ticks }; }
+        //! Wait until the player lets go of the robot.
+        static Suspension input() { return { INPUT, 0 }; }
+
+        Kind kind;
+        long ticks;
+    };
+
+    //! The Checking / Moving / Rotating / Restart cycle of one HeadlessWanderer as a resumable task.
+    //!
+    //! resume() makes the next decision with HeadlessWanderer::step(), so the robot keeps everything it
+    //! was set up with (solver, corridors, policy, planner, statistics, trajectory), and returns how long
+    //! carrying it out takes: move_ticks per block, a corridor followed in fast forward included, and
+    //! turn_ticks per quarter turn, like the robot driving from center to center and turning in the
+    //! plugin. Nothing happens in between, so nothing needs to be polled. Once the robot got out or ran
+    //! out of decisions, the next resume() restarts it from its start pose, like Restart. This is a
+    //! stackless coroutine written by hand: the suspension point is the awaited kind, the locals are the
+    //! state of the robot.
+    class WandererTask
+    {
+    public:
+        //! \param robot (HeadlessWanderer) the robot, kept by reference.
+        //! \param move_ticks (long) ticks to go from one block center to the next.
+        //! \param turn_ticks (long) ticks of a quarter turn.
+        //! \param max_decisions (long) an episode is abandoned after this many decisions.
+        WandererTask(HeadlessWanderer &robot, long move_ticks, long turn_ticks, long max_decisions)
+            : robot(&robot), move_ticks(move_ticks), turn_ticks(turn_ticks), max_decisions(max_decisions),
+              start_x(0), start_y(0), start_heading(MazeGrid::RIGHT), waiting(Suspension::INPUT),
+              episodes(0), exited(0), exit_steps(0), steps(0), decisions(0) {}
+
+        //! Sets the start pose of every episode and starts the first one, the first resume() decides.
+        void start(int x, int y, int heading) {
+            start_x = x;
+            start_y = y;
+            start_heading = heading;
+            robot->restart(x, y, heading);
+            waiting = Suspension::INPUT;
+        }
+
+        //! Runs the task until its next suspension.
+        //! \return what the task waits for now.
+        Suspension resume() {
+            const EpisodeResult &result = robot->result;
+            if (result.exited || result.decisions >= max_decisions) {
+                robot->finish();
+                episodes++;
+                exited += result.exited;
+                exit_steps += result.exited ? result.steps : 0;
+                robot->restart(start_x, start_y, start_heading);
+            }
+            long moved = result.steps, turned = result.rotations;
+            robot->step();
+            decisions++;
+            moved = result.steps - moved;
+            turned = result.rotations - turned;
+            steps += moved;
+            if (moved > 0) {
+                waiting = Suspension::ARRIVED;
+                return Suspension::arrived(moved * move_ticks + turned * turn_ticks);
+            }
+            waiting = Suspension::TURNED;
+            return Suspension::turned(turned * turn_ticks);
+        }
+
+        //! The player takes the robot where its last decision put it, what is left of the move or turn is dropped.
+        void take_over() { waiting = Suspension::INPUT; }
+
+        HeadlessWanderer *robot;
+        long move_ticks;
+        long turn_ticks;
+        long max_decisions;
+        int start_x;
+        int start_y;
+        int start_heading;
+        Suspension::Kind waiting;   //!< where the task is suspended
+        long episodes;              //!< episodes finished, got out or abandoned
+        long exited;                //!< episodes in which the robot got out
+        long exit_steps;            //!< steps of those episodes
+        long steps;
+        long decisions;
+    };
+
+    //! Resumes the tasks of many robots only when what they wait for happens.
+    //!
+    //! Timed suspensions go into a timer wheel with one bucket per tick, so a tick only touches the
+    //! robots whose move or turn ends then. A robot held by the player is parked and costs nothing until
+    //! signal() is called. The cost of a tick follows the number of robots that have work, not the number
+    //! of robots, unlike StateMachine, which calls during() on the current state of every robot every tick.
+    //!
+    //! The scheduler drives headless robots only. In enviro the world calls update() on the processes of
+    //! every agent on every tick and the physics moves the robot in between, so an agent can not be left
+    //! out of a tick, and the plugin keeps its StateMachine.
+    class TaskScheduler
+    {
+    public:
+        //! \param tasks (vector) the robots, kept by reference and not resized afterwards.
+        //! \param wheel_bits (int) the wheel has 2^wheel_bits buckets, longer waits go around more than once.
+        TaskScheduler(std::vector<WandererTask> &tasks, int wheel_bits = 8)
+            : tasks(tasks), wheel((size_t) 1 << wheel_bits), mask(((size_t) 1 << wheel_bits) - 1), now(0),
+              generation(tasks.size(), 0) {}
+
+        //! Makes every robot decide on the next tick.
+        void start() {
+            for (size_t i = 0; i < tasks.size(); i++) {
+                signal(i);
+            }
+        }
+
+        //! Advances the clock by one tick and resumes the robots that have work.
+        //! \return the number of resumed robots.
+        long tick() {
+            now++;
+            long resumed = 0;
+            due.swap(ready);
+            ready.clear();
+            std::vector<Entry> &bucket = wheel[now & mask];
+            for (size_t i = 0; i < bucket.size();) {
+                if (bucket[i].due == now) {
+                    due.push_back(bucket[i]);
+                    bucket[i] = bucket.back(); // Order within a tick does not matter, every robot has its own map
+                    bucket.pop_back();
+                } else {
+                    i++; // Another turn of the wheel
+                }
+            }
+            for (const Entry &e : due) {
+                if (e.generation != generation[e.task]) {
+                    continue; // Cancelled by take_over()
+                }
+                resumed++;
+                suspend(e.task, tasks[e.task].resume());
+            }
+            due.clear();
+            return resumed;
+        }
+
+        //! The player takes robot i: its pending wake up is cancelled and it is parked.
+        void take_over(size_t i) {
+            generation[i]++;
+            tasks[i].take_over();
+        }
+
+        //! The awaited input of robot i changed, e.g. the player let go: it is resumed on the next tick.
+        void signal(size_t i) {
+            generation[i]++;
+            ready.push_back({ now + 1, i, generation[i] });
+        }
+
+        long time() const { return now; }
+
+    private:
+        struct Entry
+        {
+            long due;
+            size_t task;
+            uint32_t generation;
+        };
+
+        void suspend(size_t i, const Suspension &s) {
+            if (s.kind == Suspension::INPUT) {
+                return; // Parked until signal()
+            }
+            long at = now + (s.ticks > 0 ? s.ticks : 1);
+            wheel[at & mask].push_back({ at, i, generation[i] });
+        }
+
+        std::vector<WandererTask> &tasks;
+        std::vector<std::vector<Entry>> wheel;
+        size_t mask;
+        long now;
+        std::vector<uint32_t> generation; //!< bumped to cancel the pending wake up of a robot
+        std::vector<Entry> ready;         //!< signalled robots, resumed on the next tick
+        std::vector<Entry> due;
+    };
+
+}
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef __SEEN_MAP__H
+#define __SEEN_MAP__H
+
+#include <iostream>
+#include <memory>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <algorithm>
+
+namespace
+{
+
+    //! A class that keeps track of how many times each block of the maze has been visited.
+    //!
+    //! The counts are stored in one contiguous row-major array sized from the maze definition,
+    //! the block (x, y) lives at index y * width + x. Every method takes the column first and the row second.
+    //! An example shows the robot has visited (0,0) 1 time, (1,0) 1 time, (2,0) 1 time and (3,0) one time
+    //! in a 7x7 maze
+    //! 1, 1, 1, 1, 0, 0, 0
+    //! 0, 0, 0, 0, 0, 0, 0
+    //! 0, 0, 0, 0, 0, 0, 0
+    //! 0, 0, 0, 0, 0, 0, 0
+    //! 0, 0, 0, 0, 0, 0, 0
+    //! 0, 0, 0, 0, 0, 0, 0
+    //! 0, 0, 0, 0, 0, 0, 0
+    //!
+    //! A map is either private to one robot, or shared by several cooperating robots. The counters are
+    //! relaxed atomics in both cases: a private map reads and writes them like plain integers, a shared map
+    //! increments them with a compare-and-swap so robots on different threads never wait on a lock.
+    //!
+    //! Each counter shares a 32-bit word with the epoch it was written in, and a counter from an older
+    //! epoch reads as 0. reset_map() only starts a new epoch, so a restart costs the same on a 7x7 maze
+    //! as on a 2000x2000 one. The epochs are 16 bits. Every reset also zeroes the next few stale counters,
+    //! sweeping the whole map within SWEEP_PERIOD resets, long before the epoch wraps around and could
+    //! bring an old counter back.
+    class SeenMap
+    {
+    public:
+        //! Resets between two visits of the sweep to the same counter, less than half the 65535 epochs.
+        static constexpr size_t SWEEP_PERIOD = 32768;
+
+        //! Creates a map of width x height blocks, all the values are initialized to 0.
+        //! \param width (int) number of columns of the maze.
+        //! \param height (int) number of rows of the maze.
+        //! \param shared (bool) true when several robots update the map concurrently.
+        SeenMap(int width = 7, int height = 7, bool shared = false) : map_width(0), map_height(0), shared(shared) {
+            resize(width, height);
+        }
+
+        //! Resizes the map to width x height blocks, all the values are reset to 0.
+        //! Must not be called while other robots use the map.
+        void resize(int width, int height) {
+            map_width = width;
+            map_height = height;
+            size_t size = (size_t) width * height;
+            map.reset(new std::atomic<uint32_t>[size]);
+            for (size_t i = 0; i < size; i++) {
+                map[i].store(0, std::memory_order_relaxed); // Epoch 0 is never current, so 0 reads as unvisited
+            }
+            epoch = 1;
+            sweep_cursor = 0;
+            sweep_step = std::max<size_t>(1, (size + SWEEP_PERIOD - 1) / SWEEP_PERIOD);
+        }
+
+        int width() const { return map_width; }
+        int height() const { return map_height; }
+        bool is_shared() const { return shared; }
+
+        //! Get the value of the block located in the given (x, y) position of the matrix.
+        //! \param x (int) the column of the matrix.
+        //! \param y (int) the row of the matrix.
+        //! \return value of the block, if the (x, y) is out of boundary, it returns the maximum integer value.
+        int get_value(int x, int y) const {
+            if ((unsigned) x >= (unsigned) map_width || (unsigned) y >= (unsigned) map_height) {
+                return INT_MAX;
+            }
+            return count(map[(size_t) y * map_width + x].load(std::memory_order_relaxed));
+        }
+
+        //! Reads the values of the four blocks around (x, y) in heading order: right, down, left, up.
+        //! Blocks outside of the maze read as the maximum integer value, like get_value().
+        //! \param x (int) the column of the matrix.
+        //! \param y (int) the row of the matrix.
+        //! \param values (int[4]) receives the four values.
+        void neighbours(int x, int y, int values[4]) const {
+            if (x > 0 && y > 0 && x < map_width - 1 && y < map_height - 1) {
+                // Inner block, the left and right values share a cache line with (x, y)
+                const std::atomic<uint32_t> *cell = &map[(size_t) y * map_width + x];
+                values[0] = count(cell[1].load(std::memory_order_relaxed));
+                values[1] = count(cell[map_width].load(std::memory_order_relaxed));
+                values[2] = count(cell[-1].load(std::memory_order_relaxed));
+                values[3] = count(cell[-map_width].load(std::memory_order_relaxed));
+            } else {
+                values[0] = get_value(x + 1, y);
+                values[1] = get_value(x, y + 1);
+                values[2] = get_value(x - 1, y);
+                values[3] = get_value(x, y - 1);
+            }
+        }
+
+        //! Increases the value of the block located in the given (x, y) position of the matrix by one.
+        //! \param x (int) the column of the matrix.
+        //! \param y (int) the row of the matrix.
+        void set_to_visited(int x, int y) {
+            if ((unsigned) x >= (unsigned) map_width || (unsigned) y >= (unsigned) map_height) {
+                return;
+            }
+            std::atomic<uint32_t> &cell = map[(size_t) y * map_width + x];
+            uint32_t value = cell.load(std::memory_order_relaxed);
+            if (!shared) {
+                if (count(value) != COUNT_MAX) {
+                    cell.store(stamp(count(value) + 1), std::memory_order_relaxed);
+                }
+                return;
+            }
+            while (count(value) != COUNT_MAX && !cell.compare_exchange_weak(value, stamp(count(value) + 1), std::memory_order_relaxed)) {
+            }
+        }
+
+        //! Sets the value of the block located in the given (x, y) position, e.g. to restore a recorded map.
+        //! \param x (int) the column of the matrix.
+        //! \param y (int) the row of the matrix.
+        //! \param value (int) the new value, saturated to COUNT_MAX.
+        void set_value(int x, int y, int value) {
+            if ((unsigned) x >= (unsigned) map_width || (unsigned) y >= (unsigned) map_height) {
+                return;
+            }
+            map[(size_t) y * map_width + x].store(stamp(std::min<int>(std::max(value, 0), COUNT_MAX)), std::memory_order_relaxed);
+        }
+
+        //! Resets all the values in the matrix to 0 by starting a new epoch, in constant time.
+        //! Must not be called while other robots use the map.
+        void reset_map(){
+            epoch = epoch == EPOCH_MAX ? 1 : epoch + 1;
+            size_t size = (size_t) map_width * map_height;
+            for (size_t i = 0; i < sweep_step && size > 0; i++) {
+                map[sweep_cursor].store(0, std::memory_order_relaxed); // Older than the new epoch, so 0 already
+                sweep_cursor = sweep_cursor + 1 == size ? 0 : sweep_cursor + 1;
+            }
+        }
+
+        //! Prints the current state of the matrix to the standard output in the form of comma-separated values.
+        void draw() const {
+            for(int i = 0; i<map_height; i++){
+                for(int j = 0; j<map_width; j++) {
+                    std::cout << get_value(j, i) << ",";
+                }
+                std::cout<<std::endl;
+            }
+        }
+
+    private:
+    static constexpr uint32_t COUNT_MAX = 0xffff;
+    static constexpr uint32_t EPOCH_MAX = 0xffff;
+
+    //! \return the counter of a word, 0 when it was written in another epoch.
+    int count(uint32_t word) const { return (word >> 16) == epoch ? (int) (word & COUNT_MAX) : 0; }
+    //! \return the word of a counter written in the current epoch.
+    uint32_t stamp(uint32_t value) const { return epoch << 16 | value; }
+
+    //! Row-major values of the blocks in the matrix, the epoch in the high half and the count in the low half.
+    std::unique_ptr<std::atomic<uint32_t>[]> map;
+    int map_width;
+    int map_height;
+    bool shared;
+    uint32_t epoch;         //!< 1 to EPOCH_MAX, 0 only stamps counters zeroed by the sweep
+    size_t sweep_cursor;    //!< next counter zeroed by reset_map()
+    size_t sweep_step;      //!< counters zeroed by each reset_map()
+    };
+
+}
+
+#endif
@@ -0,0 +1,275 @@
+#ifndef __SWARM__H
+#define __SWARM__H
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include "maze_grid.h"
+#include "seen_map.h"
+#include "wander_policy.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SWARM_X86 1
+#endif
+
+namespace
+{
+
+    //! Batch versions of the least visited rule, deciding for many robots at once.
+    //!
+    //! The inputs are structure-of-arrays: for robot i, open[i] is its free space mask and front[i],
+    //! right[i] and left[i] are the visit counts of the blocks around it. The output turn[i] is 0 to move
+    //! forward, 1 to turn right and -1 to turn left, the same turn decide() would make. The vector kernels
+    //! evaluate the rule with compares and masks instead of the table: front when it is open and visited
+    //! no more than every other open side, else right when it is open and visited no more than the left,
+    //! else left when it is open, else right. This is the table for every ordering real counts can have.
+    namespace swarm
+    {
+        enum Kernel { SCALAR, SSE2, AVX2 };
+
+        //! The turn of the least visited rule indexed by free space mask * 8 + neighbour ordering.
+        constexpr std::array<signed char, 64> make_turn_table() {
+            std::array<signed char, 64> table = {};
+            for (int open = 0; open < 8; open++) {
+                for (int order = 0; order < 8; order++) {
+                    table[open * 8 + order] = least_visited_turn(open, order);
+                }
+            }
+            return table;
+        }
+
+        constexpr std::array<signed char, 64> TURN_TABLE = make_turn_table();
+
+        inline void decide_scalar(const int32_t *open, const int32_t *front, const int32_t *right, const int32_t *left,
+                                  int32_t *turn, size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                int order = (front[i] <= right[i]) | (front[i] <= left[i]) << 1 | (right[i] <= left[i]) << 2;
+                turn[i] = TURN_TABLE[(open[i] & 7) * 8 + order];
+            }
+        }
+
+#ifdef SWARM_X86
+        //! 4 robots per vector, two vectors per iteration.
+        inline void decide_sse2(const int32_t *open, const int32_t *front, const int32_t *right, const int32_t *left,
+                                int32_t *turn, size_t n) {
+            const __m128i one = _mm_set1_epi32(1), two = _mm_set1_epi32(2), four = _mm_set1_epi32(4);
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                __m128i o = _mm_loadu_si128((const __m128i *) (open + i));
+                __m128i f = _mm_loadu_si128((const __m128i *) (front + i));
+                __m128i r = _mm_loadu_si128((const __m128i *) (right + i));
+                __m128i l = _mm_loadu_si128((const __m128i *) (left + i));
+                __m128i open_f = _mm_cmpeq_epi32(_mm_and_si128(o, one), one);
+                __m128i open_r = _mm_cmpeq_epi32(_mm_and_si128(o, two), two);
+                __m128i open_l = _mm_cmpeq_epi32(_mm_and_si128(o, four), four);
+                __m128i f_gt_r = _mm_cmpgt_epi32(f, r), f_gt_l = _mm_cmpgt_epi32(f, l), r_gt_l = _mm_cmpgt_epi32(r, l);
+                // front = F & (!R | f <= r) & (!L | f <= l), with !R | f <= r written as !(R & f > r)
+                __m128i go_f = _mm_andnot_si128(_mm_or_si128(_mm_and_si128(open_r, f_gt_r), _mm_and_si128(open_l, f_gt_l)), open_f);
+                __m128i go_r = _mm_andnot_si128(_mm_or_si128(go_f, _mm_and_si128(open_l, r_gt_l)), open_r);
+                __m128i go_l = _mm_andnot_si128(_mm_or_si128(go_f, go_r), open_l);
+                __m128i t = _mm_or_si128(_mm_andnot_si128(go_l, _mm_andnot_si128(go_f, one)), go_l);
+                _mm_storeu_si128((__m128i *) (turn + i), t);
+            }
+            decide_scalar(open + i, front + i, right + i, left + i, turn + i, n - i);
+        }
+
+        //! 8 robots per vector, the same steps as decide_sse2(). Compiled for AVX2 whatever the build flags,
+        //! only called when the processor has it.
+        __attribute__((target("avx2")))
+        inline void decide_avx2(const int32_t *open, const int32_t *front, const int32_t *right, const int32_t *left,
+                                int32_t *turn, size_t n) {
+            const __m256i one = _mm256_set1_epi32(1), two = _mm256_set1_epi32(2), four = _mm256_set1_epi32(4);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m256i o = _mm256_loadu_si256((const __m256i *) (open + i));
+                __m256i f = _mm256_loadu_si256((const __m256i *) (front + i));
+                __m256i r = _mm256_loadu_si256((const __m256i *) (right + i));
+                __m256i l = _mm256_loadu_si256((const __m256i *) (left + i));
+                __m256i open_f = _mm256_cmpeq_epi32(_mm256_and_si256(o, one), one);
+                __m256i open_r = _mm256_cmpeq_epi32(_mm256_and_si256(o, two), two);
+                __m256i open_l = _mm256_cmpeq_epi32(_mm256_and_si256(o, four), four);
+                __m256i f_gt_r = _mm256_cmpgt_epi32(f, r), f_gt_l = _mm256_cmpgt_epi32(f, l), r_gt_l = _mm256_cmpgt_epi32(r, l);
+                __m256i go_f = _mm256_andnot_si256(_mm256_or_si256(_mm256_and_si256(open_r, f_gt_r), _mm256_and_si256(open_l, f_gt_l)), open_f);
+                __m256i go_r = _mm256_andnot_si256(_mm256_or_si256(go_f, _mm256_and_si256(open_l, r_gt_l)), open_r);
+                __m256i go_l = _mm256_andnot_si256(_mm256_or_si256(go_f, go_r), open_l);
+                __m256i t = _mm256_or_si256(_mm256_andnot_si256(go_l, _mm256_andnot_si256(go_f, one)), go_l);
+                _mm256_storeu_si256((__m256i *) (turn + i), t);
+            }
+            decide_sse2(open + i, front + i, right + i, left + i, turn + i, n - i);
+        }
+#endif
+
+        //! \return the fastest kernel the processor runs.
+        inline Kernel best_kernel() {
+#ifdef SWARM_X86
+            return __builtin_cpu_supports("avx2") ? AVX2 : SSE2;
+#else
+            return SCALAR;
+#endif
+        }
+
+        inline const char *kernel_name(Kernel kernel) {
+            return kernel == AVX2 ? "avx2" : kernel == SSE2 ? "sse2" : "scalar";
+        }
+
+        //! Runs the given kernel, or the scalar one when the build has no vector kernels.
+        inline void decide_batch(Kernel kernel, const int32_t *open, const int32_t *front, const int32_t *right,
+                                 const int32_t *left, int32_t *turn, size_t n) {
+#ifdef SWARM_X86
+            if (kernel == AVX2) {
+                decide_avx2(open, front, right, left, turn, n);
+                return;
+            } else if (kernel == SSE2) {
+                decide_sse2(open, front, right, left, turn, n);
+                return;
+            }
+#endif
+            decide_scalar(open, front, right, left, turn, n);
+        }
+    }
+
+    //! Many wandering robots on one maze, each with its own visit map, deciding in lockstep.
+    //!
+    //! The poses, free space masks and neighbour counts of the robots still in the maze are kept as
+    //! structure-of-arrays in the first active() slots. Every step gathers their inputs, decides for all
+    //! of them with one batch kernel, then applies the decisions like HeadlessWanderer::step() does with
+    //! the built-in rule. A robot that gets out swaps slots with the last active one, so the kernel never
+    //! runs on finished robots. Each robot therefore walks exactly the path it would walk alone. Fast
+    //! forward, the other policies and random tie breaks are not supported.
+    class Swarm
+    {
+    public:
+        //! \param grid (MazeGrid) the maze, kept by reference.
+        //! \param agents (int) number of robots.
+        Swarm(const MazeGrid &grid, int agents)
+            : grid(grid), maze_exit(MazeExit::of(grid)), kernel(swarm::best_kernel()), in_maze(0), x(agents), y(agents),
+              heading(agents), open(agents), front(agents), right(agents), left(agents), turn(agents), robot(agents),
+              slot(agents), steps(agents), decisions(agents), exited(agents, true) {
+            maps.reserve(agents);
+            for (int i = 0; i < agents; i++) {
+                maps.emplace_back(grid.width(), grid.height());
+                robot[i] = slot[i] = i;
+            }
+        }
+
+        //! Picks the batch kernel, e.g. to compare them. Defaults to swarm::best_kernel().
+        void use_kernel(swarm::Kernel k) { kernel = k; }
+        swarm::Kernel current_kernel() const { return kernel; }
+
+        //! Places robot i on a cleared visit map and clears its statistics.
+        void start(int i, int start_x, int start_y, int start_heading) {
+            maps[i].reset_map();
+            steps[i] = decisions[i] = 0;
+            if (exited[i]) {
+                exited[i] = false;
+                swap_slots(slot[i], in_maze++);
+            }
+            int s = slot[i];
+            x[s] = start_x;
+            y[s] = start_y;
+            heading[s] = start_heading & 3;
+        }
+
+        //! Makes one decision for every robot still in the maze and applies it.
+        //! \return the number of robots still in the maze.
+        size_t step() {
+            for (size_t s = 0; s < in_maze; s++) {
+                int h = heading[s], counts[4];
+                open[s] = grid.open_sides(x[s], y[s], h);
+                maps[robot[s]].neighbours(x[s], y[s], counts);
+                front[s] = counts[h];
+                right[s] = counts[(h + 1) & 3];
+                left[s] = counts[(h + 3) & 3];
+            }
+            swarm::decide_batch(kernel, open.data(), front.data(), right.data(), left.data(), turn.data(), in_maze);
+            for (size_t s = 0; s < in_maze;) {
+                int i = robot[s];
+                decisions[i]++;
+                int t = turn[s], out = heading[s];
+                if (x[s] == maze_exit.x && y[s] == maze_exit.y) {
+                    // Face the opening and move out, like wander_decision()
+                    t = EXIT_TURN[(maze_exit.heading - heading[s]) & 3];
+                    out = maze_exit.heading;
+                }
+                if (t != 0) {
+                    heading[s] = (heading[s] + t) & 3;
+                    s++;
+                    continue;
+                }
+                maps[i].set_to_visited(x[s], y[s]);
+                steps[i]++;
+                int nx = x[s] + MazeGrid::dx(out), ny = y[s] + MazeGrid::dy(out);
+                if (!grid.in_bounds(nx, ny)) {
+                    exited[i] = true;
+                    swap_slots(s, --in_maze); // The last active robot, not applied yet, takes this slot
+                    continue;
+                }
+                x[s] = nx;
+                y[s] = ny;
+                s++;
+            }
+            return in_maze;
+        }
+
+        //! Steps until every robot is out or has made max_decisions decisions.
+        void run(long max_decisions) {
+            for (long d = 0; d < max_decisions && step() > 0; d++) {
+            }
+        }
+
+        //! Takes robot i out of the maze without an exit, e.g. when there are fewer episodes than robots.
+        void stop(int i) {
+            if (!exited[i]) {
+                swap_slots(slot[i], --in_maze);
+                exited[i] = true;
+            }
+        }
+
+        size_t size() const { return maps.size(); }
+        size_t active() const { return in_maze; }
+
+        //! \return true when robot i left the maze.
+        bool is_out(int i) const { return exited[i] && steps[i] > 0; }
+
+        const MazeGrid &grid;
+        MazeExit maze_exit;
+        swarm::Kernel kernel;
+        size_t in_maze;                 //!< the robots in the maze are in the first slots
+        // One entry per slot
+        std::vector<int32_t> x;
+        std::vector<int32_t> y;
+        std::vector<int32_t> heading;
+        std::vector<int32_t> open;      //!< free space mask of the last decision
+        std::vector<int32_t> front;     //!< visit count of the block ahead at the last decision
+        std::vector<int32_t> right;
+        std::vector<int32_t> left;
+        std::vector<int32_t> turn;      //!< output of the batch kernel
+        std::vector<int> robot;         //!< the robot in the slot
+        // One entry per robot
+        std::vector<int> slot;
+        std::vector<long> steps;
+        std::vector<long> decisions;
+        std::vector<char> exited;       //!< out of the maze, or stopped
+        std::vector<SeenMap> maps;
+
+    private:
+        void swap_slots(size_t a, size_t b) {
+            if (a == b) {
+                return;
+            }
+            std::swap(x[a], x[b]);
+            std::swap(y[a], y[b]);
+            std::swap(heading[a], heading[b]);
+            std::swap(turn[a], turn[b]);
+            std::swap(robot[a], robot[b]);
+            slot[robot[a]] = a;
+            slot[robot[b]] = b;
+        }
+    };
+
+}
+
+#endif
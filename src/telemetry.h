@@ -0,0 +1,275 @@
+#ifndef __TELEMETRY__H
+#define __TELEMETRY__H
+
+#include <string>
+#include <vector>
+#include <array>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include <json/json.h>
+#include "player_input.h"
+
+namespace
+{
+
+    //! Counters and timers of one WandererController.
+    //!
+    //! The states update the counters from the simulation thread only, so they are plain integers. Every
+    //! snapshot interval, and at the end of every episode, a copy of the counters is pushed into a
+    //! single-producer single-consumer ring that the TelemetryWriter thread drains to a JSON lines file.
+    //! A controller without telemetry keeps a null pointer, each instrumented call is one test.
+    class Telemetry
+    {
+    public:
+        enum StateId { MOVING, ROTATING, CHECKING, RESTART, INPLAY, GTCC, STATE_COUNT };
+
+        //! during() latencies are binned by powers of two, bucket i counts the calls of [2^(i-1), 2^i) ns.
+        static constexpr int BUCKETS = 32;
+        static constexpr int RING_SIZE = 64;
+
+        //! A copy of the counters, as handed to the writer thread.
+        struct Record
+        {
+            enum Kind { SNAPSHOT, EPISODE } kind;
+            double time;                                //!< seconds since the telemetry was created
+            std::array<long, STATE_COUNT> ticks;        //!< during() calls of every state
+            std::array<long, STATE_COUNT> transitions;  //!< entries of every state, one per fired event
+            std::array<long, BUCKETS> latency;          //!< histogram of the during() latencies
+            long decisions;                             //!< Checking decisions since the start
+            double decisions_per_s;                     //!< over the last snapshot interval
+            long episodes;
+            long steps;                                 //!< of the current (or the finished) episode
+            long rotations;
+            long revisits;                              //!< steps into a block visited before
+            bool exited;                                //!< EPISODE records only, false when it was restarted
+            InputStats input;                           //!< the player's keyboard input since the start
+        };
+
+        //! \param agent (int) the agent id, used in the records.
+        //! \param events (vector) the name of the event leading into every state, in StateId order.
+        //! \param interval (double) seconds between two snapshots.
+        Telemetry(int agent, const std::vector<std::string> &events, double interval)
+            : agent(agent), event_names(events), interval(interval), begin(std::chrono::steady_clock::now()),
+              head(0), tail(0), dropped(0), version(0) {
+            current = {};
+            last_snapshot = 0.0;
+            last_decisions = 0;
+        }
+
+        //! Counts the entry into a state, i.e. one transition fired by the state's event.
+        void entered(StateId state) { current.transitions[state]++; }
+
+        //! Records one during() call that took the given time.
+        void ticked(StateId state, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+            current.ticks[state]++;
+            long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+            int bucket = ns <= 0 ? 0 : 64 - __builtin_clzll(ns);
+            current.latency[bucket < BUCKETS ? bucket : BUCKETS - 1]++;
+            double now = std::chrono::duration<double>(end - begin).count();
+            if (now - last_snapshot >= interval) {
+                snapshot(Record::SNAPSHOT, now);
+            }
+        }
+
+        void decided() { current.decisions++; }
+        void rotated() { current.rotations++; }
+
+        //! \param revisit (bool) true when the block moved into was visited before.
+        void stepped(bool revisit) {
+            current.steps++;
+            current.revisits += revisit;
+        }
+
+        //! Ends the current episode, an episode without any step or rotation is ignored.
+        //! \param exited (bool) true when the robot got out, false when it was restarted.
+        void episode_end(bool exited) {
+            if (current.steps == 0 && current.rotations == 0) {
+                return;
+            }
+            current.episodes++;
+            current.exited = exited;
+            snapshot(Record::EPISODE, std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+            current.steps = current.rotations = current.revisits = 0;
+        }
+
+        //! Pops the oldest record, called by the writer thread only.
+        //! \return false when the ring is empty.
+        bool pop(Record &r) {
+            size_t t = tail.load(std::memory_order_relaxed);
+            if (t == head.load(std::memory_order_acquire)) {
+                return false;
+            }
+            r = ring[t % RING_SIZE];
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        //! A short summary of the last snapshot for the on-screen display.
+        //! The version changes every time the text does.
+        const std::string &display() const { return text; }
+        long display_version() const { return version; }
+
+        //! Formats a record as one JSON object.
+        nlohmann::json to_json(const Record &r) const {
+            static const char *states[STATE_COUNT] = { "Moving", "Rotating", "Checking", "Restart", "Inplay", "GoToClosestCenter" };
+            nlohmann::json ticks, transitions;
+            for (int i = 0; i < STATE_COUNT; i++) {
+                ticks[states[i]] = r.ticks[i];
+                transitions[event_names[i]] = r.transitions[i];
+            }
+            nlohmann::json j = {
+                { "agent", agent },
+                { "kind", r.kind == Record::EPISODE ? "episode" : "snapshot" },
+                { "time", r.time },
+                { "episodes", r.episodes },
+                { "steps", r.steps },
+                { "rotations", r.rotations },
+                { "revisits", r.revisits },
+                { "decisions", r.decisions },
+                { "decisions_per_s", r.decisions_per_s },
+                { "ticks", ticks },
+                { "transitions", transitions },
+                { "during_ns_log2", r.latency },
+                { "dropped", dropped.load(std::memory_order_relaxed) }
+            };
+            if (r.kind == Record::EPISODE) {
+                j["exited"] = r.exited;
+            }
+            if (input != nullptr) {
+                j["input"] = {
+                    { "events", r.input.events },
+                    { "repeats", r.input.repeats },
+                    { "commands", r.input.commands },
+                    { "coalesced", r.input.coalesced },
+                    { "latency_p50_ns", r.input.percentile(0.5) },
+                    { "latency_p99_ns", r.input.percentile(0.99) },
+                    { "latency_max_ns", r.input.max_ns },
+                    { "latency_ns_log2", r.input.latency }
+                };
+            }
+            return j;
+        }
+
+        const int agent;
+        const InputStats *input = nullptr; //!< the player's input counters, copied into every record when set
+
+    private:
+        void snapshot(Record::Kind kind, double now) {
+            double elapsed = now - last_snapshot;
+            current.kind = kind;
+            current.time = now;
+            if (input != nullptr) {
+                current.input = *input;
+            }
+            if (kind == Record::SNAPSHOT) {
+                current.decisions_per_s = elapsed > 0 ? (current.decisions - last_decisions) / elapsed : 0.0;
+                last_snapshot = now;
+                last_decisions = current.decisions;
+                text = "steps " + std::to_string(current.steps) + " rot " + std::to_string(current.rotations)
+                     + " rev " + std::to_string(current.revisits) + " " + std::to_string((long) current.decisions_per_s) + " dec/s";
+                version++;
+            }
+            size_t h = head.load(std::memory_order_relaxed);
+            if (h - tail.load(std::memory_order_acquire) == RING_SIZE) {
+                dropped.fetch_add(1, std::memory_order_relaxed); // The writer is behind, keep the older records
+                return;
+            }
+            ring[h % RING_SIZE] = current;
+            head.store(h + 1, std::memory_order_release);
+        }
+
+        std::vector<std::string> event_names;
+        double interval;
+        std::chrono::steady_clock::time_point begin;
+        Record current;
+        double last_snapshot;
+        long last_decisions;
+        std::string text;
+
+        std::array<Record, RING_SIZE> ring;
+        std::atomic<size_t> head; //!< next record written by the simulation thread
+        std::atomic<size_t> tail; //!< next record read by the writer thread
+        std::atomic<long> dropped;
+        long version;
+    };
+
+    //! Times one during() call, does nothing when the telemetry is disabled.
+    class TelemetryScope
+    {
+    public:
+        TelemetryScope(Telemetry *telemetry, Telemetry::StateId state) : telemetry(telemetry), state(state) {
+            if (telemetry != nullptr) {
+                start = std::chrono::steady_clock::now();
+            }
+        }
+        ~TelemetryScope() {
+            if (telemetry != nullptr) {
+                telemetry->ticked(state, start, std::chrono::steady_clock::now());
+            }
+        }
+
+    private:
+        Telemetry *telemetry;
+        Telemetry::StateId state;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    //! Drains the telemetry of every registered controller to a JSON lines file from its own thread.
+    class TelemetryWriter
+    {
+    public:
+        //! \return the writer of the process, started on the first call.
+        //! \param path (string) the file to append to, only used by the first call.
+        static TelemetryWriter &instance(const std::string &path, double interval) {
+            static TelemetryWriter writer(path, interval);
+            return writer;
+        }
+
+        //! Starts draining a controller's telemetry, which stays alive as long as the writer needs it.
+        void add(std::shared_ptr<Telemetry> telemetry) {
+            std::lock_guard<std::mutex> lock(mutex);
+            sources.push_back(telemetry);
+        }
+
+        ~TelemetryWriter() {
+            stop.store(true);
+            thread.join();
+        }
+
+    private:
+        TelemetryWriter(const std::string &path, double interval) : out(path, std::ios::app), stop(false) {
+            thread = std::thread([this, interval]() {
+                auto period = std::chrono::duration<double>(interval);
+                while (!stop.load()) {
+                    std::this_thread::sleep_for(period);
+                    flush();
+                }
+                flush();
+            });
+        }
+
+        void flush() {
+            std::lock_guard<std::mutex> lock(mutex);
+            Telemetry::Record r;
+            for (auto &t : sources) {
+                while (t->pop(r)) {
+                    out << t->to_json(r).dump() << "\n";
+                }
+            }
+            out.flush();
+        }
+
+        std::ofstream out;
+        std::mutex mutex; //!< guards the sources, the simulation thread only takes it to add one
+        std::vector<std::shared_ptr<Telemetry>> sources;
+        std::atomic<bool> stop;
+        std::thread thread;
+    };
+
+}
+
+#endif
@@ -0,0 +1,314 @@
+#ifndef __TILED_MAZE__H
+#define __TILED_MAZE__H
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "maze_grid.h"
+
+namespace
+{
+
+    //! The layout of a tiled maze file, written by tiled_maze::write() and mapped by TiledMaze.
+    //!
+    //! The maze is cut into square tiles of TILE x TILE blocks, TILE a power of two, and every tile is
+    //! stored in a fixed-size record, so the record of a block is found with shifts and no index. The
+    //! header fills the first PAGE bytes: the magic "WMT1", the uint32 width, height, tile size, flags,
+    //! exit column, exit row and exit heading (all 0xFFFFFFFF when the maze has no exit), then the block
+    //! size and the origin as doubles at offsets 32, 40 and 48. Host byte order, like the .grid files.
+    //! The tile records follow in row-major tile order: the wall masks of the tile packed two blocks per
+    //! byte (the even block in the low nibble) in row-major order, then, with the VISITS flag, one uint16
+    //! visit counter per block, padded to a multiple of PAGE so every tile is paged in on its own. Blocks
+    //! of the last column and row of tiles that are past the maze are unused. The counters are written as
+    //! zeros without being stored: the file is sparse until something writes them back.
+    namespace tiled_maze
+    {
+        constexpr char MAGIC[4] = { 'W', 'M', 'T', '1' };
+        constexpr size_t PAGE = 4096;
+        constexpr int DEFAULT_TILE = 64;
+        constexpr uint32_t NO_EXIT = 0xFFFFFFFF;
+
+        enum Flags { VISITS = 1 };
+        enum Field { WIDTH = 4, HEIGHT = 8, TILE = 12, FLAGS = 16, EXIT_X = 20, EXIT_Y = 24, EXIT_HEADING = 28,
+                     CELL = 32, LEFT = 40, TOP = 48 };
+
+        //! \return the bytes of the wall masks of a tile.
+        inline size_t walls_size(int tile) { return (size_t) tile * tile / 2; }
+
+        //! \return the bytes of one tile record.
+        inline size_t tile_stride(int tile, bool visits) {
+            size_t size = walls_size(tile) + (visits ? (size_t) tile * tile * sizeof(uint16_t) : 0);
+            return (size + PAGE - 1) / PAGE * PAGE;
+        }
+
+        //! \return the number of tiles needed for n blocks.
+        inline int tiles(int blocks, int tile) { return (blocks + tile - 1) / tile; }
+
+        //! \return the size of the file of a width x height maze.
+        inline size_t file_size(int width, int height, int tile, bool visits) {
+            return PAGE + (size_t) tiles(width, tile) * tiles(height, tile) * tile_stride(tile, visits);
+        }
+
+        //! Writes a maze as a tiled file, one tile at a time.
+        //! \param grid (MazeGrid) the maze, e.g. rasterized from config.json.
+        //! \param path (string) the tiled file, replaced when it exists.
+        //! \param tile (int) blocks per side of a tile, a power of two from 2 to 4096.
+        //! \param visits (bool) true to keep room for the visit counters.
+        inline void write(const MazeGrid &grid, const std::string &path, int tile = DEFAULT_TILE, bool visits = true) {
+            if (tile < 2 || tile > 4096 || (tile & (tile - 1)) != 0) {
+                throw std::runtime_error("the tile size must be a power of two from 2 to 4096");
+            }
+            int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0) {
+                throw std::runtime_error("could not create " + path);
+            }
+            bool ok = ftruncate(fd, file_size(grid.width(), grid.height(), tile, visits)) == 0;
+            std::vector<unsigned char> buffer(PAGE, 0), walls(walls_size(tile));
+            int exit_x = 0, exit_y = 0, exit_heading = 0;
+            bool has_exit = grid.find_exit(exit_x, exit_y, exit_heading);
+            uint32_t header[7] = { (uint32_t) grid.width(), (uint32_t) grid.height(), (uint32_t) tile, visits ? (uint32_t) VISITS : 0u,
+                                   has_exit ? (uint32_t) exit_x : NO_EXIT, has_exit ? (uint32_t) exit_y : NO_EXIT,
+                                   has_exit ? (uint32_t) exit_heading : NO_EXIT };
+            double geometry[3] = { grid.cell_size(), grid.origin_x(), grid.origin_y() };
+            std::memcpy(buffer.data(), MAGIC, 4);
+            std::memcpy(buffer.data() + WIDTH, header, sizeof(header));
+            std::memcpy(buffer.data() + CELL, geometry, sizeof(geometry));
+            ok = ok && pwrite(fd, buffer.data(), PAGE, 0) == (ssize_t) PAGE;
+            size_t stride = tile_stride(tile, visits);
+            int tiles_x = tiles(grid.width(), tile), tiles_y = tiles(grid.height(), tile);
+            for (int ty = 0; ty < tiles_y && ok; ty++) {
+                for (int tx = 0; tx < tiles_x && ok; tx++) {
+                    std::fill(walls.begin(), walls.end(), 0);
+                    for (int y = 0; y < tile; y++) {
+                        for (int x = 0; x < tile; x++) {
+                            int gx = tx * tile + x, gy = ty * tile + y, i = y * tile + x;
+                            if (grid.in_bounds(gx, gy)) {
+                                walls[i / 2] |= grid.wall_mask(gx, gy) << (i % 2 * 4);
+                            }
+                        }
+                    }
+                    off_t at = PAGE + ((off_t) ty * tiles_x + tx) * stride;
+                    ok = pwrite(fd, walls.data(), walls.size(), at) == (ssize_t) walls.size();
+                }
+            }
+            ok = ::close(fd) == 0 && ok;
+            if (!ok) {
+                throw std::runtime_error("could not write " + path);
+            }
+        }
+    }
+
+    //! A maze read from a tiled file without loading it: the file is memory-mapped and the kernel reads
+    //! a tile in when a robot first looks at one of its blocks.
+    //!
+    //! Opening takes the same time whatever the size of the maze, and the memory used follows the blocks
+    //! the robots explore: the mapping is advised as random access, so the kernel does not read ahead,
+    //! and approach() asks for the tiles around a robot when it enters a new tile, so they are read while
+    //! it is still busy with the current one. The visit counters of the file are mapped copy-on-write,
+    //! only the tiles a robot visits get private pages, and the file is never modified.
+    //!
+    //! TiledMaze answers open_sides() like a MazeGrid and neighbours() like a SeenMap, so the wander
+    //! policy runs on it directly. Unlike a SeenMap it is private to one robot.
+    class TiledMaze
+    {
+    public:
+        //! \param path (string) a file written by tiled_maze::write().
+        TiledMaze(const std::string &path) : data(nullptr), size(0), current_tile(-1), tiles_read(0) {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::runtime_error("could not open " + path);
+            }
+            struct stat st;
+            if (fstat(fd, &st) == 0 && (size_t) st.st_size >= tiled_maze::PAGE) {
+                size = st.st_size;
+                void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+                data = p == MAP_FAILED ? nullptr : (unsigned char *) p;
+            }
+            ::close(fd);
+            if (data == nullptr || std::memcmp(data, tiled_maze::MAGIC, 4) != 0) {
+                release();
+                throw std::runtime_error(path + " is not a tiled maze file");
+            }
+            maze_width = field(tiled_maze::WIDTH);
+            maze_height = field(tiled_maze::HEIGHT);
+            tile = field(tiled_maze::TILE);
+            visits = field(tiled_maze::FLAGS) & tiled_maze::VISITS;
+            if (maze_width <= 0 || maze_height <= 0 || tile < 2 || tile > 4096 || (tile & (tile - 1)) != 0
+                || tiled_maze::file_size(maze_width, maze_height, tile, visits) != size) {
+                release();
+                throw std::runtime_error(path + " is truncated or corrupted");
+            }
+            std::memcpy(&cell, data + tiled_maze::CELL, sizeof(double));
+            std::memcpy(&left, data + tiled_maze::LEFT, sizeof(double));
+            std::memcpy(&top, data + tiled_maze::TOP, sizeof(double));
+            shift = __builtin_ctz(tile);
+            tiles_x = tiled_maze::tiles(maze_width, tile);
+            stride = tiled_maze::tile_stride(tile, visits);
+            counters = tiled_maze::walls_size(tile);
+            state.assign((size_t) tiles_x * tiled_maze::tiles(maze_height, tile), 0);
+            madvise(data, size, MADV_RANDOM);
+        }
+
+        TiledMaze(const TiledMaze &) = delete;
+        TiledMaze &operator=(const TiledMaze &) = delete;
+
+        ~TiledMaze() { release(); }
+
+        int width() const { return maze_width; }
+        int height() const { return maze_height; }
+        int tile_size() const { return tile; }
+        bool has_visits() const { return visits; }
+        double cell_size() const { return cell; }
+        double origin_x() const { return left; }
+        double origin_y() const { return top; }
+
+        bool in_bounds(int x, int y) const {
+            return (unsigned) x < (unsigned) maze_width && (unsigned) y < (unsigned) maze_height;
+        }
+
+        //! The exit found by the converter, no need to search the boundary.
+        //! \return true when the maze has an exit, and stores its block and heading.
+        bool find_exit(int &x, int &y, int &heading) const {
+            if (field(tiled_maze::EXIT_X) == tiled_maze::NO_EXIT) {
+                return false;
+            }
+            x = field(tiled_maze::EXIT_X);
+            y = field(tiled_maze::EXIT_Y);
+            heading = field(tiled_maze::EXIT_HEADING);
+            return true;
+        }
+
+        //! \return the 4-bit wall mask of block (x, y).
+        int wall_mask(int x, int y) const {
+            size_t i = offset(x, y);
+            return record(x, y)[i >> 1] >> ((i & 1) * 4) & 15;
+        }
+
+        bool is_open(int x, int y, int heading) const { return !(wall_mask(x, y) & (1 << (heading & 3))); }
+
+        //! Like MazeGrid::open_sides().
+        int open_sides(int x, int y, int heading) const {
+            return OPEN_SIDES_TABLE[wall_mask(x, y) * 4 + (heading & 3)];
+        }
+
+        //! \return the visits of block (x, y), the maximum integer value outside of the maze, like SeenMap.
+        int get_value(int x, int y) const {
+            if (!in_bounds(x, y)) {
+                return INT_MAX;
+            }
+            return visits ? counter(x, y) : 0;
+        }
+
+        //! Like SeenMap::neighbours().
+        void neighbours(int x, int y, int values[4]) const {
+            values[0] = get_value(x + 1, y);
+            values[1] = get_value(x, y + 1);
+            values[2] = get_value(x - 1, y);
+            values[3] = get_value(x, y - 1);
+        }
+
+        //! Counts a visit of block (x, y), the counters saturate at 65535. Does nothing without counters.
+        void set_to_visited(int x, int y) {
+            if (!visits || !in_bounds(x, y)) {
+                return;
+            }
+            uint16_t &c = counter(x, y);
+            if (c != UINT16_MAX) {
+                c++;
+            }
+            size_t t = tile_index(x, y);
+            if (!(state[t] & WRITTEN)) {
+                state[t] |= WRITTEN;
+                written.push_back(t);
+            }
+        }
+
+        //! Brings the counters back to the ones of the file by dropping the private pages of the tiles
+        //! written since the last reset, in time proportional to those tiles.
+        void reset_map() {
+            for (size_t t : written) {
+                madvise(data + tiled_maze::PAGE + t * stride, stride, MADV_DONTNEED);
+                state[t] &= ~WRITTEN;
+            }
+            written.clear();
+        }
+
+        //! Tells the maze a robot is in block (x, y). When it entered a new tile, the tiles around it that
+        //! were never asked for are read in ahead.
+        void approach(int x, int y) {
+            if (!in_bounds(x, y)) {
+                return;
+            }
+            long t = (long) tile_index(x, y);
+            if (t == current_tile) {
+                return;
+            }
+            current_tile = t;
+            int tx = x >> shift, ty = y >> shift, tiles_y = (int) (state.size() / tiles_x);
+            for (int j = std::max(ty - 1, 0); j <= std::min(ty + 1, tiles_y - 1); j++) {
+                for (int i = std::max(tx - 1, 0); i <= std::min(tx + 1, tiles_x - 1); i++) {
+                    size_t n = (size_t) j * tiles_x + i;
+                    if (!(state[n] & READ)) {
+                        state[n] |= READ;
+                        tiles_read++;
+                        madvise(data + tiled_maze::PAGE + n * stride, stride, MADV_WILLNEED);
+                    }
+                }
+            }
+        }
+
+        //! \return the tiles read in ahead by approach() so far.
+        size_t read_tiles() const { return tiles_read; }
+        size_t tile_count() const { return state.size(); }
+        size_t file_size() const { return size; }
+
+    private:
+        enum TileState { READ = 1, WRITTEN = 2 };
+
+        uint32_t field(tiled_maze::Field f) const {
+            uint32_t v;
+            std::memcpy(&v, data + f, sizeof(v));
+            return v;
+        }
+
+        size_t tile_index(int x, int y) const { return (size_t) (y >> shift) * tiles_x + (x >> shift); }
+        size_t offset(int x, int y) const { return (size_t) (y & (tile - 1)) << shift | (x & (tile - 1)); }
+        unsigned char *record(int x, int y) const { return data + tiled_maze::PAGE + tile_index(x, y) * stride; }
+        uint16_t &counter(int x, int y) const { return ((uint16_t *) (record(x, y) + counters))[offset(x, y)]; }
+
+        void release() {
+            if (data != nullptr) {
+                munmap(data, size);
+                data = nullptr;
+            }
+        }
+
+        unsigned char *data;
+        size_t size;
+        int maze_width;
+        int maze_height;
+        int tile;
+        int shift;
+        int tiles_x;
+        bool visits;
+        size_t stride;
+        size_t counters;            //!< offset of the visit counters in a tile record
+        double cell;
+        double left;
+        double top;
+        std::vector<unsigned char> state;   //!< TileState bits of every tile
+        std::vector<size_t> written;        //!< tiles with private counters
+        long current_tile;
+        size_t tiles_read;
+    };
+
+}
+
+#endif
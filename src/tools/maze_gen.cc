@@ -0,0 +1,92 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+#include "maze_gen.h"
+
+// Procedural maze generator.
+//
+// Usage: maze_gen [--width w] [--height h] [--algorithm backtracker|kruskal|wilson] [--seed s] [--braid p]
+//                 [-o maze.json] [--grid maze.grid]
+//
+// Writes a config.json with the maze as statics, and a compact grid file with the same walls that
+// wander_sim and the plugins can load without rasterizing the statics. The grid file defaults to the
+// config path with a .grid extension, where the plugins look for it: they load config.grid beside
+// config.json when it is not older, or the file of the "grid" option.
+
+int main(int argc, char **argv) {
+    int width = 7, height = 7;
+    std::string algorithm = "backtracker";
+    std::string config = "maze.json";
+    std::string grid_path;
+    uint64_t seed = 1;
+    double braiding = 0.0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--width" && i + 1 < argc) {
+            width = std::atoi(argv[++i]);
+        } else if (arg == "--height" && i + 1 < argc) {
+            height = std::atoi(argv[++i]);
+        } else if (arg == "--algorithm" && i + 1 < argc) {
+            algorithm = argv[++i];
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--braid" && i + 1 < argc) {
+            braiding = std::atof(argv[++i]);
+        } else if (arg == "-o" && i + 1 < argc) {
+            config = argv[++i];
+        } else if (arg == "--grid" && i + 1 < argc) {
+            grid_path = argv[++i];
+        } else {
+            std::cerr << "usage: " << argv[0]
+                      << " [--width w] [--height h] [--algorithm backtracker|kruskal|wilson] [--seed s] [--braid p]"
+                      << " [-o maze.json] [--grid maze.grid]" << std::endl;
+            return 1;
+        }
+    }
+    if (width <= 0 || height <= 0 || (algorithm != "backtracker" && algorithm != "kruskal" && algorithm != "wilson")) {
+        std::cerr << "error: the size must be positive and the algorithm one of backtracker, kruskal, wilson" << std::endl;
+        return 1;
+    }
+    if (grid_path.empty()) {
+        size_t dot = config.rfind('.');
+        grid_path = (dot == std::string::npos || config.find('/', dot) != std::string::npos ? config : config.substr(0, dot)) + ".grid";
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    MazeGrid grid = MazeGenerator::generate(width, height, algorithm, seed, braiding);
+    auto generated = std::chrono::steady_clock::now();
+
+    std::vector<char> buffer(1 << 20);
+    std::ofstream out;
+    out.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    out.open(config);
+    if (!out) {
+        std::cerr << "error: could not create " << config << std::endl;
+        return 1;
+    }
+    MazeGenerator::write_config(out, grid);
+    out.close();
+    if (!out) {
+        std::cerr << "error: could not write " << config << std::endl;
+        return 1;
+    }
+    try {
+        grid.save_grid(grid_path);
+    } catch (std::exception &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return 1;
+    }
+    auto written = std::chrono::steady_clock::now();
+
+    std::cout << "maze: " << width << "x" << height << ", " << algorithm << ", seed " << seed;
+    if (braiding > 0) {
+        std::cout << ", braid " << braiding;
+    }
+    std::cout << std::endl << "wrote " << config << " and " << grid_path << std::endl;
+    std::cout << "generation: " << std::chrono::duration<double>(generated - begin).count() << " s, output: "
+              << std::chrono::duration<double>(written - generated).count() << " s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include "tiled_maze.h"
+
+// Converts a maze to the tiled format that wander_sim maps without loading it.
+//
+// Usage: maze_tile config.json|maze.grid [-o maze.wmt] [--tile n] [--no-visits]
+//
+// The output defaults to the input path with a .wmt extension. --tile sets the blocks per side of a tile,
+// a power of two (64 by default), and --no-visits leaves out the visit counters, which only a robot that
+// wanders on the file needs. The file is read back and every wall mask is checked against the source.
+
+int main(int argc, char **argv) {
+    std::string input, output;
+    int tile = tiled_maze::DEFAULT_TILE;
+    bool visits = true;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg == "--tile" && i + 1 < argc) {
+            tile = std::atoi(argv[++i]);
+        } else if (arg == "--no-visits") {
+            visits = false;
+        } else if (arg[0] != '-' && input.empty()) {
+            input = arg;
+        } else {
+            input.clear();
+            break;
+        }
+    }
+    if (input.empty()) {
+        std::cerr << "usage: " << argv[0] << " config.json|maze.grid [-o maze.wmt] [--tile n] [--no-visits]" << std::endl;
+        return 1;
+    }
+    if (output.empty()) {
+        size_t dot = input.rfind('.');
+        output = (dot == std::string::npos || input.find('/', dot) != std::string::npos ? input : input.substr(0, dot)) + ".wmt";
+    }
+
+    try {
+        auto begin = std::chrono::steady_clock::now();
+        MazeGrid grid = MazeGrid::load(input);
+        auto loaded = std::chrono::steady_clock::now();
+        tiled_maze::write(grid, output, tile, visits);
+        auto written = std::chrono::steady_clock::now();
+
+        TiledMaze tiled(output);
+        long mismatches = 0;
+        for (int y = 0; y < grid.height(); y++) {
+            for (int x = 0; x < grid.width(); x++) {
+                mismatches += tiled.wall_mask(x, y) != grid.wall_mask(x, y);
+            }
+        }
+        std::cout << "maze: " << grid.width() << "x" << grid.height() << " from " << input << " in "
+                  << std::chrono::duration<double>(loaded - begin).count() << " s" << std::endl;
+        std::cout << "tiled: " << output << ", " << tiled.tile_count() << " tiles of " << tile << "x" << tile
+                  << (visits ? " with visit counters, " : ", ") << tiled.file_size() << " bytes, written in "
+                  << std::chrono::duration<double>(written - loaded).count() << " s" << std::endl;
+        if (mismatches > 0) {
+            std::cerr << "error: " << mismatches << " blocks differ from " << input << std::endl;
+            return 1;
+        }
+    } catch (std::exception &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
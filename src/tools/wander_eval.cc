@@ -0,0 +1,257 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "headless.h"
+#include "maze_gen.h"
+#include "evaluation.h"
+
+// Parallel evaluation of the wander policy over many mazes, starts and tie-break seeds.
+//
+// Usage: wander_eval [maze.json|maze.grid ...] [--generate n [--width w] [--height h] [--algorithm backtracker|kruskal|wilson] [--braid p]]
+//                    [--starts k] [--seeds k] [--policy wander,fast_forward,solve,wall_follower,tremaux]
+//                    [--max-decisions n] [--threads t] [--scaling]
+//
+// Every (maze, start, seed, policy) combination is one job. The jobs are spread over the threads by a
+// work-stealing scheduler, each thread plays its jobs with its own visit map. Seed 0 breaks the ties of
+// the wander and fast_forward policies like the plugin (front first, then right), the other seeds break
+// them at random. The other policies have no ties and are only played with seed 0. The first start is always the top left block facing right, the others are
+// drawn at random.
+//
+// The report gives, per maze and policy, the mean, percentiles and worst case of the steps-to-exit and
+// their ratio to the optimal path, then the throughput. --scaling runs the whole set again with 1, 2, 4
+// ... threads up to --threads and prints the speedup of each.
+
+namespace
+{
+
+    enum Policy { WANDER, FAST_FORWARD, SOLVE, WALL_FOLLOWER, TREMAUX, POLICY_COUNT };
+    const char *POLICY_NAMES[POLICY_COUNT] = { "wander", "fast_forward", "solve", "wall_follower", "tremaux" };
+
+    //! \return true for the policies that play a different episode with every tie-break seed.
+    inline bool breaks_ties(Policy policy) { return policy == WANDER || policy == FAST_FORWARD; }
+
+    //! A maze with everything the jobs read from it, built before the threads start.
+    struct Maze
+    {
+        std::string name;
+        std::unique_ptr<MazeGrid> grid;
+        std::unique_ptr<MazeSolver> solver;
+        std::unique_ptr<CorridorMap> corridors;
+    };
+
+    struct Job
+    {
+        int maze;
+        int x;
+        int y;
+        int heading;
+        uint64_t seed;
+        Policy policy;
+    };
+
+    //! Steps to exit (-1 when the robot did not get out) and decisions of one job.
+    struct JobResult
+    {
+        long steps;
+        long decisions;
+    };
+
+    //! Plays every job once with the given number of threads.
+    //! \return the wall clock time in seconds.
+    double evaluate(const std::vector<Maze> &mazes, const std::vector<Job> &jobs, std::vector<JobResult> &results,
+                    long max_decisions, int threads) {
+        WorkStealingPool pool(threads);
+        std::vector<std::unique_ptr<SeenMap>> seen(pool.size());
+        std::vector<std::unique_ptr<ExplorationPolicy>> explorers(pool.size() * POLICY_COUNT);
+        for (int w = 0; w < pool.size(); w++) {
+            seen[w].reset(new SeenMap(1, 1));
+            explorers[w * POLICY_COUNT + WALL_FOLLOWER] = make_policy("wall_follower");
+            explorers[w * POLICY_COUNT + TREMAUX] = make_policy("tremaux");
+        }
+        auto begin = std::chrono::steady_clock::now();
+        pool.run(jobs.size(), [&](uint32_t index, int worker) {
+            const Job &job = jobs[index];
+            const Maze &maze = mazes[job.maze];
+            SeenMap &map = *seen[worker];
+            if (map.width() != maze.grid->width() || map.height() != maze.grid->height()) {
+                map.resize(maze.grid->width(), maze.grid->height());
+            }
+            HeadlessWanderer wanderer(*maze.grid, map, job.policy == SOLVE ? maze.solver.get() : nullptr);
+            wanderer.fast_forward(job.policy == FAST_FORWARD ? maze.corridors.get() : nullptr);
+            wanderer.tie_break(job.seed);
+            wanderer.explore_with(explorers[worker * POLICY_COUNT + job.policy].get()); // Null for the built-in rule
+            EpisodeResult r = wanderer.run_episode(job.x, job.y, job.heading, max_decisions);
+            results[index] = { r.exited ? r.steps : -1, r.decisions };
+        });
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    }
+
+    //! Prints the steps-to-exit statistics of every (maze, policy) pair.
+    void report(const std::vector<Maze> &mazes, const std::vector<Job> &jobs, const std::vector<JobResult> &results,
+                const std::vector<Policy> &policies) {
+        std::cout << std::left << std::setw(24) << "maze" << std::setw(14) << "policy" << std::right
+                  << std::setw(9) << "episodes" << std::setw(8) << "exited" << std::setw(12) << "mean"
+                  << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99"
+                  << std::setw(10) << "worst" << std::setw(10) << "/optimal" << std::endl;
+        for (size_t m = 0; m < mazes.size(); m++) {
+            for (Policy policy : policies) {
+                std::vector<long> steps;
+                double optimal = 0;
+                for (size_t i = 0; i < jobs.size(); i++) {
+                    if (jobs[i].maze == (int) m && jobs[i].policy == policy) {
+                        steps.push_back(results[i].steps);
+                        if (results[i].steps >= 0) {
+                            optimal += mazes[m].solver->distance(jobs[i].x, jobs[i].y) + 1; // the last step leaves the maze
+                        }
+                    }
+                }
+                StepStatistics s = StepStatistics::of(steps);
+                std::cout << std::left << std::setw(24) << mazes[m].name << std::setw(14) << POLICY_NAMES[policy]
+                          << std::right << std::setw(9) << s.count << std::setw(8) << s.exited
+                          << std::setw(12) << std::fixed << std::setprecision(1) << s.mean
+                          << std::setw(10) << s.p50 << std::setw(10) << s.p90 << std::setw(10) << s.p99
+                          << std::setw(10) << s.worst << std::setw(10) << std::setprecision(2)
+                          << (optimal > 0 ? s.mean * s.exited / optimal : 0.0) << std::endl;
+            }
+        }
+        std::cout.unsetf(std::ios::fixed);
+        std::cout << std::setprecision(6);
+    }
+
+}
+
+int main(int argc, char **argv) {
+    std::vector<std::string> files;
+    int generated = 0, width = 50, height = 50;
+    double braid = 0.0;
+    std::string algorithm = "backtracker";
+    int starts = 1, seeds = 1;
+    long max_decisions = 100000000;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    bool scaling = false;
+    std::vector<Policy> policies = { WANDER };
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--generate" && i + 1 < argc) {
+            generated = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--width" && i + 1 < argc) {
+            width = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--height" && i + 1 < argc) {
+            height = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--algorithm" && i + 1 < argc) {
+            algorithm = argv[++i];
+        } else if (arg == "--braid" && i + 1 < argc) {
+            braid = std::atof(argv[++i]);
+        } else if (arg == "--starts" && i + 1 < argc) {
+            starts = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--seeds" && i + 1 < argc) {
+            seeds = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--max-decisions" && i + 1 < argc) {
+            max_decisions = std::atol(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--scaling") {
+            scaling = true;
+        } else if (arg == "--policy" && i + 1 < argc) {
+            policies.clear();
+            std::stringstream list(argv[++i]);
+            for (std::string name; std::getline(list, name, ',');) {
+                auto found = std::find(POLICY_NAMES, POLICY_NAMES + POLICY_COUNT, name);
+                if (found == POLICY_NAMES + POLICY_COUNT) {
+                    std::cerr << "error: unknown policy " << name << std::endl;
+                    return 1;
+                }
+                policies.push_back((Policy) (found - POLICY_NAMES));
+            }
+        } else if (arg[0] != '-') {
+            files.push_back(arg);
+        } else {
+            std::cerr << "usage: " << argv[0]
+                      << " [maze.json|maze.grid ...] [--generate n [--width w] [--height h] [--algorithm backtracker|kruskal|wilson] [--braid p]]"
+                      << " [--starts k] [--seeds k] [--policy wander,fast_forward,solve,wall_follower,tremaux] [--max-decisions n]"
+                      << " [--threads t] [--scaling]" << std::endl;
+            return 1;
+        }
+    }
+    if (algorithm != "backtracker" && algorithm != "kruskal" && algorithm != "wilson") {
+        std::cerr << "error: the algorithm must be one of backtracker, kruskal, wilson" << std::endl;
+        return 1;
+    }
+    if (files.empty() && generated == 0) {
+        files.push_back("config.json");
+    }
+
+    std::vector<Maze> mazes;
+    try {
+        for (auto &file : files) {
+            mazes.push_back({ file, std::unique_ptr<MazeGrid>(new MazeGrid(MazeGrid::load(file))), nullptr, nullptr });
+        }
+        for (int i = 0; i < generated; i++) {
+            std::string name = algorithm + "_" + std::to_string(width) + "x" + std::to_string(height) + "_" + std::to_string(i + 1);
+            mazes.push_back({ name, std::unique_ptr<MazeGrid>(new MazeGrid(MazeGenerator::generate(width, height, algorithm, i + 1, braid))),
+                              nullptr, nullptr });
+        }
+    } catch (std::exception &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return 1;
+    }
+    // Everything shared by the threads is built here and only read afterwards
+    for (auto &maze : mazes) {
+        maze.solver.reset(new MazeSolver(*maze.grid));
+        maze.solver->solve();
+        maze.corridors.reset(new CorridorMap(*maze.grid, MazeExit::of(*maze.grid)));
+    }
+
+    std::vector<Job> jobs;
+    std::mt19937 rng(1);
+    for (size_t m = 0; m < mazes.size(); m++) {
+        const MazeGrid &grid = *mazes[m].grid;
+        for (int s = 0; s < starts; s++) {
+            int x = 0, y = 0, heading = MazeGrid::RIGHT;
+            if (s > 0) {
+                x = rng() % grid.width();
+                y = rng() % grid.height();
+                heading = rng() % 4;
+            }
+            for (int seed = 0; seed < seeds; seed++) {
+                for (Policy policy : policies) {
+                    if (seed == 0 || breaks_ties(policy)) { // The other policies would repeat the same episode
+                        jobs.push_back({ (int) m, x, y, heading, (uint64_t) seed, policy });
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<JobResult> results(jobs.size());
+    std::cout << "jobs: " << jobs.size() << " (" << mazes.size() << " mazes x " << starts << " starts x "
+              << policies.size() << " policies, " << seeds << " seeds for the policies with ties)" << std::endl;
+    if (scaling) {
+        double single = 0;
+        for (int t = 1; ; t = std::min(t * 2, threads)) {
+            double seconds = evaluate(mazes, jobs, results, max_decisions, t);
+            single = t == 1 ? seconds : single;
+            std::cout << "threads " << t << ": " << seconds << " s, speedup " << single / seconds << std::endl;
+            if (t == threads) {
+                break;
+            }
+        }
+    }
+    double seconds = evaluate(mazes, jobs, results, max_decisions, threads);
+
+    report(mazes, jobs, results, policies);
+    long decisions = 0;
+    for (auto &r : results) {
+        decisions += r.decisions;
+    }
+    std::cout << "throughput: " << threads << " thread(s), " << jobs.size() / seconds << " episodes/s, "
+              << decisions / seconds << " decisions/s" << std::endl;
+    return 0;
+}
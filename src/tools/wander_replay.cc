@@ -0,0 +1,119 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include "trajectory.h"
+#include "headless.h"
+
+// Reads a trajectory recorded by the plugin or by wander_sim --record.
+//
+// Usage: wander_replay trajectory.wtr [--step k] [--dump n] [--verify maze.json|maze.grid]
+//
+// Without options it prints the size of the trajectory. --step scrubs to step k and prints the pose, the
+// tick and the visit map of the robot there, --dump prints the n steps from there. --verify replays the
+// whole trajectory on the maze: every sensed free space mask is checked against the walls, and the wander
+// policy is run again from every recorded state to check that it makes the recorded decision. Decisions
+// made by the solver, or with random tie breaks, are reported as mismatches.
+
+namespace
+{
+
+    const char *ACTION_NAMES[4] = { "move", "turn right", "turn left", "pass" };
+
+}
+
+int main(int argc, char **argv) {
+    std::string path, maze;
+    long step = -1, dump = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--step" && i + 1 < argc) {
+            step = std::atol(argv[++i]);
+        } else if (arg == "--dump" && i + 1 < argc) {
+            dump = std::atol(argv[++i]);
+        } else if (arg == "--verify" && i + 1 < argc) {
+            maze = argv[++i];
+        } else if (arg[0] != '-' && path.empty()) {
+            path = arg;
+        } else {
+            path.clear();
+            break;
+        }
+    }
+    if (path.empty()) {
+        std::cerr << "usage: " << argv[0] << " trajectory.wtr [--step k] [--dump n] [--verify maze.json|maze.grid]" << std::endl;
+        return 1;
+    }
+
+    try {
+        TrajectoryReplay replay(path);
+        std::cout << "trajectory: " << replay.width() << "x" << replay.height() << " maze, " << replay.steps() << " steps, "
+                  << replay.keyframes() << " keyframes every " << replay.keyframe_interval() << " steps, "
+                  << (double) replay.bytes() / std::max<uint64_t>(1, replay.steps()) << " bytes/step"
+                  << (replay.indexed() ? "" : " (no index, rebuilt)") << std::endl;
+
+        if (step >= 0) {
+            auto begin = std::chrono::steady_clock::now();
+            replay.seek(step);
+            double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+            const GridPose &pose = replay.pose();
+            std::cout << "step " << replay.step() << " (tick " << replay.tick() << ", found in " << us << " us): block ("
+                      << pose.x << ", " << pose.y << ") heading " << pose.heading << std::endl;
+            if (replay.width() * replay.height() <= 400) {
+                replay.seen().draw();
+            }
+        }
+        TrajectoryReplay::Step s;
+        for (long i = 0; i < dump && replay.next(s); i++) {
+            std::cout << replay.step() - 1 << " tick " << s.tick << ": (" << s.pose.x << ", " << s.pose.y << ") heading "
+                      << s.pose.heading << " open " << s.open << " " << ACTION_NAMES[s.action];
+            if (s.action == trajectory::PASS) {
+                std::cout << " out " << s.heading;
+            }
+            std::cout << std::endl;
+        }
+
+        if (!maze.empty()) {
+            MazeGrid grid = MazeGrid::load(maze);
+            if (grid.width() != replay.width() || grid.height() != replay.height()) {
+                std::cerr << "error: " << maze << " is " << grid.width() << "x" << grid.height() << std::endl;
+                return 1;
+            }
+            GridBody body(grid);
+            MazeExit exit = MazeExit::of(grid);
+            long decisions = 0, sensed = 0, decided = 0;
+            replay.rewind();
+            while (replay.peek()) {
+                const GridPose &pose = replay.pose();
+                body.x = pose.x;
+                body.y = pose.y;
+                body.heading = pose.heading;
+                Decision d = wander_decision(body, body.pose(), replay.seen(), exit);
+                int action = d.kind == Decision::MOVE ? trajectory::MOVE : d.rate > 0 ? trajectory::TURN_RIGHT : trajectory::TURN_LEFT;
+                uint64_t at = replay.step();
+                replay.next(s);
+                if (s.action == trajectory::PASS) {
+                    continue;
+                }
+                decisions++;
+                if (grid.open_sides(body.x, body.y, body.heading) != s.open) {
+                    sensed++;
+                }
+                if (action != s.action) {
+                    if (decided == 0) {
+                        std::cout << "first policy mismatch at step " << at << ": recorded " << ACTION_NAMES[s.action]
+                                  << ", policy " << ACTION_NAMES[action] << std::endl;
+                    }
+                    decided++;
+                }
+            }
+            std::cout << "verified " << decisions << " decisions: " << sensed << " sensor mismatches, "
+                      << decided << " policy mismatches" << std::endl;
+            return sensed + decided > 0 ? 2 : 0;
+        }
+    } catch (std::exception &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,535 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <fstream>
+#include "headless.h"
+#include "scheduler.h"
+#include "bench/polling_scheduler.h"
+#include "swarm.h"
+#include "tiled_maze.h"
+
+// Headless batch simulator for the wander policy.
+//
+// Usage: wander_sim [config.json|maze.grid|maze.wmt] [-n episodes] [--max-decisions n] [--random-starts] [--seed s] [--solve]
+//                   [--fast-forward] [--policy name] [--record trajectory.wtr] [--stats file.wvs [--prior]]
+//                   [--agents n [--shared] [--threads t] [--scheduler wheel|poll [--held n]]]
+//                   [--swarm n [--kernel scalar|sse2|avx2] [--check]] [--lookahead depth [--rollouts k] [--threads t]]
+//
+// With --solve the robot follows the exit distance field like the "Solve" mode. In both modes the
+// optimal number of steps is reported as a reference for the quality of the policy.
+//
+// With --fast-forward the robots go through whole corridors between two decisions, like the
+// "fast_forward" option of the plugin.
+//
+// With --policy the robots wander with another policy than the least visited rule: wall_follower,
+// tremaux, or auto for the one that gets out of the maze in the fewest steps from the top left block.
+//
+// With --record every decision of the single robot is appended to a trajectory file, which
+// wander_replay can scrub through and check against the policy.
+//
+// With --stats the visits, dead ends and steps-to-exit of the single robot are added to a visit
+// statistics file, kept across runs like the "visit_stats" option of the plugin. With --prior the least
+// visited rule avoids the dead ends found in the file.
+//
+// With --lookahead the single robot plans each move at a junction with rollouts of depth decisions of
+// the least visited rule, k for each way out (4 by default), spread over --threads threads.
+//
+// With --agents several robots explore the maze together until the first one gets out, each with its
+// own visit map or, with --shared, cooperating on one map. --threads spreads the robots over threads.
+//
+// With --scheduler the robots of --agents wander on their own clock, resumed by the timer wheel of
+// TaskScheduler (wheel) or looked at on every tick like the state machine (poll), 20 ticks per block and
+// 5 per quarter turn, until they finished the episodes. --held makes the player hold n of the robots,
+// which the wheel never looks at. Both schedulers give the same paths, the time of a tick follows the
+// robots with work with the wheel and all the robots with polling.
+//
+// With --swarm the episodes are played n at a time by a Swarm, n robots deciding in lockstep with one
+// vectorized kernel. Every robot walks the path it would walk alone, --check replays each episode with
+// the single robot simulator and reports any difference.
+//
+// A .wmt maze, written by maze_tile, is mapped instead of loaded, and the robot wanders on it with the
+// least visited rule and the visit counters of the file, so only the tiles it explores are read in.
+// The time to open the maze and the memory used at the end are reported. The other modes need the
+// whole maze, and wander_sim refuses their options with a .wmt maze.
+
+//! \return the resident memory of the process in bytes, 0 when it is unknown.
+long resident_bytes() {
+    std::ifstream statm("/proc/self/statm");
+    long pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+//! Plays the episodes of a single robot on a mapped tiled maze and prints how much of it was read in.
+int run_tiled(const std::string &path, long episodes, long max_decisions, bool random_starts, std::mt19937 &rng) {
+    long before = resident_bytes();
+    auto begin = std::chrono::steady_clock::now();
+    std::unique_ptr<TiledMaze> maze;
+    try {
+        maze.reset(new TiledMaze(path));
+    } catch (std::exception &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return 1;
+    }
+    double open_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    if (!maze->has_visits()) {
+        std::cerr << "error: " << path << " has no visit counters, convert it without --no-visits" << std::endl;
+        return 1;
+    }
+    MazeExit exit;
+    maze->find_exit(exit.x, exit.y, exit.heading);
+    long exited = 0, total_steps = 0, total_decisions = 0;
+    begin = std::chrono::steady_clock::now();
+    for (long e = 0; e < episodes; e++) {
+        GridPose pose = { 0, 0, MazeGrid::RIGHT, true };
+        if (random_starts) {
+            pose = { (int) (rng() % maze->width()), (int) (rng() % maze->height()), (int) (rng() % 4), true };
+        }
+        maze->reset_map();
+        long steps = 0, decisions = 0;
+        while (decisions < max_decisions) {
+            maze->approach(pose.x, pose.y);
+            Decision d = wander_decision(*maze, pose, *maze, exit);
+            decisions++;
+            if (d.kind == Decision::ROTATE) {
+                pose.rotate(d.rate);
+                continue;
+            }
+            maze->set_to_visited(pose.x, pose.y);
+            steps++;
+            if (!maze->in_bounds(d.x, d.y)) {
+                exited++;
+                total_steps += steps;
+                break;
+            }
+            pose.x = d.x;
+            pose.y = d.y;
+        }
+        total_decisions += decisions;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << "maze: " << maze->width() << "x" << maze->height() << " mapped from " << path << " in "
+              << open_seconds * 1e3 << " ms" << std::endl;
+    std::cout << "episodes: " << episodes << ", exited: " << exited << std::endl;
+    if (exited > 0) {
+        std::cout << "steps-to-exit: mean " << (double) total_steps / exited << std::endl;
+    }
+    std::cout << "throughput: " << episodes / seconds << " episodes/s, " << total_decisions / seconds << " decisions/s" << std::endl;
+    std::cout << "tiles read: " << maze->read_tiles() << " of " << maze->tile_count() << ", memory: "
+              << (resident_bytes() - before) / 1024 << " KiB resident for a " << maze->file_size() / 1024 << " KiB file" << std::endl;
+    return 0;
+}
+
+//! Plays episodes of a team of robots and prints how many decisions the first robot out needed.
+int run_teams(const MazeGrid &grid, MazeSolver *solver, const CorridorMap *corridors, const std::string &policy,
+              long episodes, long max_decisions, int agents, bool shared, int threads, bool random_starts, std::mt19937 &rng) {
+    SeenMap team_map(grid.width(), grid.height(), true);
+    std::vector<SeenMap> own_maps;
+    if (!shared) {
+        own_maps.reserve(agents);
+        for (int i = 0; i < agents; i++) {
+            own_maps.emplace_back(grid.width(), grid.height());
+        }
+    }
+    std::vector<HeadlessWanderer> team;
+    std::vector<std::unique_ptr<ExplorationPolicy>> policies;
+    for (int i = 0; i < agents; i++) {
+        team.emplace_back(grid, shared ? team_map : own_maps[i], solver);
+        team.back().fast_forward(corridors);
+        policies.push_back(make_policy(policy));
+        team.back().explore_with(policies.back().get());
+    }
+    long exited = 0, total_rounds = 0, total_decisions = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (long e = 0; e < episodes; e++) {
+        team_map.reset_map();
+        for (auto &map : own_maps) {
+            map.reset_map();
+        }
+        for (auto &robot : team) {
+            if (random_starts) {
+                robot.start(rng() % grid.width(), rng() % grid.height(), rng() % 4);
+            } else {
+                robot.start(0, 0, MazeGrid::RIGHT);
+            }
+        }
+        TeamResult r = threads > 1 ? run_team_parallel(team, max_decisions, threads) : run_team(team, max_decisions);
+        total_decisions += r.decisions;
+        if (r.exited) {
+            exited++;
+            total_rounds += r.rounds;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << "team: " << agents << " robots, " << (shared ? "shared" : "private") << " visit maps, "
+              << threads << " thread(s)" << std::endl;
+    std::cout << "episodes: " << episodes << ", exited: " << exited << std::endl;
+    if (exited > 0) {
+        std::cout << "decisions of the first robot out: mean " << (double) total_rounds / exited << std::endl;
+    }
+    std::cout << "throughput: " << episodes / seconds << " episodes/s, "
+              << total_decisions / seconds << " decisions/s" << std::endl;
+    return 0;
+}
+
+//! Drives a team of robots with a scheduler, held robots included, until the others finished the episodes,
+//! and prints the time of a tick and how many robots it resumed.
+template <class Scheduler>
+int run_scheduled(const MazeGrid &grid, MazeSolver *solver, const CorridorMap *corridors, const std::string &policy,
+                  long episodes, long max_decisions, int agents, int held, bool shared, bool random_starts, std::mt19937 &rng) {
+    const long move_ticks = 20, turn_ticks = 5; // About 1/3 s per block and 1/12 s per turn at 60 frames per second
+    SeenMap team_map(grid.width(), grid.height(), true);
+    std::vector<SeenMap> own_maps;
+    std::vector<HeadlessWanderer> team;
+    std::vector<std::unique_ptr<ExplorationPolicy>> policies;
+    std::vector<WandererTask> tasks;
+    own_maps.reserve(agents);
+    team.reserve(agents);
+    tasks.reserve(agents);
+    for (int i = 0; i < agents; i++) {
+        if (!shared) {
+            own_maps.emplace_back(grid.width(), grid.height());
+        }
+        team.emplace_back(grid, shared ? team_map : own_maps[i], solver);
+        team.back().fast_forward(corridors);
+        policies.push_back(make_policy(policy));
+        team.back().explore_with(policies.back().get());
+        tasks.emplace_back(team.back(), move_ticks, turn_ticks, max_decisions);
+        if (random_starts) {
+            tasks.back().start(rng() % grid.width(), rng() % grid.height(), rng() % 4);
+        } else {
+            tasks.back().start(0, 0, MazeGrid::RIGHT);
+        }
+    }
+    Scheduler scheduler(tasks);
+    scheduler.start();
+    for (int i = 0; i < held; i++) {
+        scheduler.take_over(i); // The player holds the first robots
+    }
+
+    long finished = 0, resumed = 0;
+    auto begin = std::chrono::steady_clock::now();
+    while (finished < episodes) {
+        for (int t = 0; t < 256; t++) {
+            resumed += scheduler.tick();
+        }
+        finished = 0;
+        for (auto &task : tasks) {
+            finished += task.episodes;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    long exited = 0, exit_steps = 0, decisions = 0;
+    for (auto &task : tasks) {
+        exited += task.exited;
+        exit_steps += task.exit_steps;
+        decisions += task.decisions;
+    }
+    std::cout << "team: " << agents << " robots, " << held << " held by the player, " << (shared ? "shared" : "private")
+              << " visit maps" << std::endl;
+    std::cout << "episodes: " << finished << ", exited: " << exited << std::endl;
+    if (exited > 0) {
+        std::cout << "steps-to-exit: mean " << (double) exit_steps / exited << std::endl;
+    }
+    std::cout << "ticks: " << scheduler.time() << ", resumed per tick: " << (double) resumed / scheduler.time()
+              << ", time per tick: " << seconds / scheduler.time() * 1e6 << " us" << std::endl;
+    std::cout << "throughput: " << decisions / seconds << " decisions/s" << std::endl;
+    return 0;
+}
+
+//! Plays the episodes batch by batch with a Swarm and prints the same statistics as a single robot.
+int run_swarm(const MazeGrid &grid, MazeSolver &solver, long episodes, long max_decisions, int size, const std::string &kernel,
+              bool check, bool random_starts, std::mt19937 &rng) {
+    Swarm swarm(grid, size);
+    if (kernel == "scalar") {
+        swarm.use_kernel(swarm::SCALAR);
+    } else if (kernel == "sse2") {
+        swarm.use_kernel(swarm::SSE2);
+    } else if (kernel == "avx2") {
+        swarm.use_kernel(swarm::AVX2);
+    } else if (!kernel.empty()) {
+        std::cerr << "error: unknown kernel " << kernel << std::endl;
+        return 1;
+    }
+    SeenMap seen(grid.width(), grid.height());
+    HeadlessWanderer single(grid, seen);
+    std::vector<int> starts(3 * size);
+    long exited = 0, total_steps = 0, total_optimal = 0, total_decisions = 0, mismatches = 0;
+    double seconds = 0;
+    for (long done = 0; done < episodes; done += size) {
+        int batch = (int) std::min<long>(size, episodes - done);
+        for (int i = 0; i < size; i++) {
+            int x = 0, y = 0, heading = MazeGrid::RIGHT;
+            if (random_starts && i < batch) {
+                x = rng() % grid.width();
+                y = rng() % grid.height();
+                heading = rng() % 4;
+            }
+            starts[3 * i] = x;
+            starts[3 * i + 1] = y;
+            starts[3 * i + 2] = heading;
+            swarm.start(i, x, y, heading);
+            if (i >= batch) {
+                swarm.stop(i); // The robots past the last episode sit out
+            }
+        }
+        auto begin = std::chrono::steady_clock::now();
+        swarm.run(max_decisions);
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        for (int i = 0; i < batch; i++) {
+            total_decisions += swarm.decisions[i];
+            bool out = swarm.is_out(i);
+            if (out) {
+                exited++;
+                total_steps += swarm.steps[i];
+                total_optimal += solver.distance(starts[3 * i], starts[3 * i + 1]) + 1;
+            }
+            if (check) {
+                EpisodeResult r = single.run_episode(starts[3 * i], starts[3 * i + 1], starts[3 * i + 2], max_decisions);
+                if (r.exited != out || r.steps != swarm.steps[i] || r.decisions != swarm.decisions[i]) {
+                    mismatches++;
+                }
+            }
+        }
+    }
+
+    std::cout << "swarm: " << size << " robots, " << swarm::kernel_name(swarm.current_kernel()) << " kernel" << std::endl;
+    std::cout << "episodes: " << episodes << ", exited: " << exited << std::endl;
+    if (exited > 0) {
+        std::cout << "steps-to-exit: mean " << (double) total_steps / exited << ", policy / optimal "
+                  << (double) total_steps / total_optimal << std::endl;
+    }
+    std::cout << "throughput: " << episodes / seconds << " episodes/s, " << total_decisions / seconds << " decisions/s" << std::endl;
+    if (check) {
+        std::cout << "check: " << mismatches << " episodes differ from the single robot" << std::endl;
+    }
+    return mismatches == 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    std::string config = "config.json";
+    long episodes = 1000;
+    long max_decisions = 1000000;
+    bool random_starts = false;
+    bool solve = false;
+    std::string policy = "least_visited";
+    bool shared = false;
+    bool fast_forward = false;
+    int agents = 1;
+    int threads = 1;
+    unsigned seed = 1;
+    std::string record;
+    std::string stats_file;
+    bool prior = false;
+    int swarm_size = 0;
+    std::string kernel;
+    bool check = false;
+    int lookahead = 0;
+    int rollouts = 4;
+    std::string scheduler;
+    int held = 0;
+    std::string grid_only; // The last option that needs the maze loaded, a tiled maze only wanders
+    auto usage = [&]() {
+        std::cerr << "usage: " << argv[0]
+                  << " [config.json|maze.grid|maze.wmt] [-n episodes] [--max-decisions n] [--random-starts] [--seed s] [--solve]"
+                  << " [--fast-forward] [--policy name] [--record trajectory.wtr] [--stats file.wvs [--prior]]"
+                  << " [--agents n [--shared] [--threads t] [--scheduler wheel|poll [--held n]]]"
+                  << " [--swarm n [--kernel scalar|sse2|avx2] [--check]] [--lookahead depth [--rollouts k] [--threads t]]" << std::endl;
+        return 1;
+    };
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        for (const char *option : { "--solve", "--fast-forward", "--policy", "--record", "--stats", "--prior", "--swarm",
+                                    "--kernel", "--check", "--lookahead", "--rollouts", "--agents", "--shared", "--threads",
+                                    "--scheduler", "--held" }) {
+            if (arg == option) {
+                grid_only = arg;
+            }
+        }
+        if (arg == "-n" && i + 1 < argc) {
+            episodes = std::atol(argv[++i]);
+        } else if (arg == "--max-decisions" && i + 1 < argc) {
+            max_decisions = std::atol(argv[++i]);
+        } else if (arg == "--random-starts") {
+            random_starts = true;
+        } else if (arg == "--solve") {
+            solve = true;
+        } else if (arg == "--fast-forward") {
+            fast_forward = true;
+        } else if (arg == "--policy" && i + 1 < argc) {
+            policy = argv[++i];
+        } else if (arg == "--record" && i + 1 < argc) {
+            record = argv[++i];
+        } else if (arg == "--stats" && i + 1 < argc) {
+            stats_file = argv[++i];
+        } else if (arg == "--prior") {
+            prior = true;
+        } else if (arg == "--swarm" && i + 1 < argc) {
+            swarm_size = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--kernel" && i + 1 < argc) {
+            kernel = argv[++i];
+        } else if (arg == "--check") {
+            check = true;
+        } else if (arg == "--lookahead" && i + 1 < argc) {
+            lookahead = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--rollouts" && i + 1 < argc) {
+            rollouts = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--agents" && i + 1 < argc) {
+            agents = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--scheduler" && i + 1 < argc) {
+            scheduler = argv[++i];
+        } else if (arg == "--held" && i + 1 < argc) {
+            held = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--shared") {
+            shared = true;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::atoi(argv[++i]);
+        } else if (arg[0] != '-') {
+            config = arg;
+        } else {
+            return usage();
+        }
+    }
+
+    if (config.size() > 4 && config.compare(config.size() - 4, 4, ".wmt") == 0) {
+        if (!grid_only.empty()) {
+            std::cerr << "error: " << grid_only << " needs a loaded maze, " << config
+                      << " only takes -n, --max-decisions, --random-starts and --seed" << std::endl;
+            return usage();
+        }
+        std::mt19937 rng(seed);
+        return run_tiled(config, episodes, max_decisions, random_starts, rng);
+    }
+    MazeGrid grid;
+    try {
+        grid = MazeGrid::load(config);
+    } catch (std::exception &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    MazeSolver solver(grid);
+    solver.solve();
+    CorridorMap corridors(grid, MazeExit::of(grid));
+    const CorridorMap *corridor_map = fast_forward ? &corridors : nullptr;
+    if (policy == "auto") {
+        policy = fastest_policy(grid, policy_names(), 0, 0, MazeGrid::RIGHT, max_decisions);
+        std::cout << "policy: " << policy << " (fastest from the top left block)" << std::endl;
+    } else if (make_policy(policy) == nullptr) {
+        std::cerr << "error: unknown policy " << policy << std::endl;
+        return 1;
+    }
+    if (policy == "least_visited" && !prior) {
+        policy.clear(); // The built-in rule, the same decisions without a virtual call
+    }
+    std::mt19937 rng(seed);
+    if (swarm_size > 0) {
+        std::cout << "maze: " << grid.width() << "x" << grid.height() << " from " << config << std::endl;
+        return run_swarm(grid, solver, episodes, max_decisions, swarm_size, kernel, check, random_starts, rng);
+    }
+    if (!scheduler.empty()) {
+        if ((scheduler != "wheel" && scheduler != "poll") || held >= agents) {
+            std::cerr << "error: --scheduler is wheel or poll, and at least one of the --agents must not be --held" << std::endl;
+            return 1;
+        }
+        std::cout << "maze: " << grid.width() << "x" << grid.height() << " from " << config << ", scheduler: " << scheduler << std::endl;
+        auto run = scheduler == "wheel" ? run_scheduled<TaskScheduler> : run_scheduled<PollingScheduler>;
+        return run(grid, solve ? &solver : nullptr, corridor_map, policy, episodes, max_decisions, agents, held, shared,
+                   random_starts, rng);
+    }
+    if (agents > 1) {
+        std::cout << "maze: " << grid.width() << "x" << grid.height() << " from " << config << std::endl;
+        return run_teams(grid, solve ? &solver : nullptr, corridor_map, policy, episodes, max_decisions, agents, shared,
+                         std::min(threads, agents), random_starts, rng);
+    }
+    SeenMap seen(grid.width(), grid.height());
+    HeadlessWanderer wanderer(grid, seen, solve ? &solver : nullptr);
+    wanderer.fast_forward(corridor_map);
+    std::unique_ptr<ExplorationPolicy> explorer = make_policy(policy);
+    wanderer.explore_with(explorer.get());
+    std::unique_ptr<LookaheadPlanner> planner;
+    if (lookahead > 0) {
+        planner.reset(new LookaheadPlanner(grid, lookahead, rollouts, threads));
+        wanderer.plan_with(planner.get());
+    }
+    std::unique_ptr<TrajectoryRecorder> recorder;
+    if (!record.empty()) {
+        try {
+            recorder.reset(new TrajectoryRecorder(record, grid.width(), grid.height()));
+        } catch (std::exception &e) {
+            std::cerr << "error: " << e.what() << std::endl;
+            return 1;
+        }
+        wanderer.record(recorder.get());
+    }
+    std::unique_ptr<VisitStats> stats;
+    std::unique_ptr<VisitStatsFeed> feed;
+    if (!stats_file.empty()) {
+        try {
+            stats.reset(new VisitStats(stats_file, grid.width(), grid.height()));
+        } catch (std::exception &e) {
+            std::cerr << "error: " << e.what() << std::endl;
+            return 1;
+        }
+        feed.reset(new VisitStatsFeed(*stats));
+        wanderer.count_visits(feed.get());
+        if (prior && explorer != nullptr) {
+            explorer->use_prior(stats.get());
+        }
+    }
+    long exited = 0, total_steps = 0, total_optimal = 0, total_decisions = 0, min_steps = -1, max_steps = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (long i = 0; i < episodes; i++) {
+        int x = 0, y = 0, heading = MazeGrid::RIGHT;
+        if (random_starts) {
+            x = rng() % grid.width();
+            y = rng() % grid.height();
+            heading = rng() % 4;
+        }
+        EpisodeResult r = wanderer.run_episode(x, y, heading, max_decisions);
+        total_decisions += r.decisions;
+        if (r.exited) {
+            exited++;
+            total_steps += r.steps;
+            total_optimal += solver.distance(x, y) + 1; // the last step leaves the maze
+            min_steps = min_steps < 0 ? r.steps : std::min(min_steps, r.steps);
+            max_steps = std::max(max_steps, r.steps);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << "maze: " << grid.width() << "x" << grid.height() << " from " << config << std::endl;
+    std::cout << "episodes: " << episodes << ", exited: " << exited << std::endl;
+    if (exited > 0) {
+        std::cout << "steps-to-exit: mean " << (double) total_steps / exited
+                  << ", min " << min_steps << ", max " << max_steps << std::endl;
+        std::cout << "optimal steps-to-exit: mean " << (double) total_optimal / exited
+                  << ", policy / optimal " << (double) total_steps / total_optimal << std::endl;
+    }
+    std::cout << "decisions: mean " << (double) total_decisions / episodes << " per episode" << std::endl;
+    std::cout << "throughput: " << episodes / seconds << " episodes/s, "
+              << total_decisions / seconds << " decisions/s" << std::endl;
+    if (stats != nullptr) {
+        std::cout << "visit statistics: " << stats->episodes() << " episodes, " << stats->exits() << " exited in total"
+                  << (prior ? ", dead ends avoided" : "") << std::endl;
+    }
+    if (planner != nullptr) {
+        std::cout << "lookahead: depth " << lookahead << ", " << rollouts << " rollouts per way, " << threads << " thread(s), "
+                  << planner->plans() << " plans, " << planner->rollouts_played() << " rollouts" << std::endl;
+    }
+    if (recorder != nullptr) {
+        std::cout << "recorded: " << recorder->recorded_steps() << " steps, "
+                  << (double) recorder->written_bytes() / std::max(1L, recorder->recorded_steps()) << " bytes/step" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include "visit_stats.h"
+
+// Reads a visit statistics file kept by the plugin or by wander_sim --stats.
+//
+// Usage: wander_stats visit_stats.wvs [--top n] [--grid visits|dead_ends]
+//
+// Prints the episodes, the steps-to-exit and their histogram, then the n blocks where the robots hit a
+// dead end most often. --grid prints the visits or the dead end hits of every block as comma-separated
+// rows. The file is only mapped read-only, it can be read while robots are updating it.
+
+int main(int argc, char **argv) {
+    std::string path, grid;
+    long top = 10;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--top" && i + 1 < argc) {
+            top = std::atol(argv[++i]);
+        } else if (arg == "--grid" && i + 1 < argc) {
+            grid = argv[++i];
+        } else if (arg[0] != '-' && path.empty()) {
+            path = arg;
+        } else {
+            path.clear();
+            break;
+        }
+    }
+    if (path.empty() || (!grid.empty() && grid != "visits" && grid != "dead_ends")) {
+        std::cerr << "usage: " << argv[0] << " visit_stats.wvs [--top n] [--grid visits|dead_ends]" << std::endl;
+        return 1;
+    }
+
+    try {
+        VisitStats stats(path);
+        std::cout << "visit statistics: " << stats.width() << "x" << stats.height() << " maze, " << stats.episodes()
+                  << " episodes, " << stats.exits() << " exited" << std::endl;
+        if (stats.exits() > 0) {
+            std::cout << "steps-to-exit: mean " << (double) stats.exit_steps() / stats.exits() << ", min "
+                      << stats.min_exit_steps() << std::endl;
+            for (int i = 0; i < visit_stats::BUCKETS; i++) {
+                if (stats.exit_histogram(i) > 0) {
+                    std::cout << "  [" << (i == 0 ? 0 : 1L << (i - 1)) << ", " << (1L << i) << "): "
+                              << stats.exit_histogram(i) << std::endl;
+                }
+            }
+        }
+
+        std::vector<std::pair<uint32_t, int>> dead_ends;
+        uint64_t visits = 0;
+        for (int y = 0; y < stats.height(); y++) {
+            for (int x = 0; x < stats.width(); x++) {
+                visits += stats.visits(x, y);
+                if (stats.dead_ends(x, y) > 0) {
+                    dead_ends.push_back({ stats.dead_ends(x, y), y * stats.width() + x });
+                }
+            }
+        }
+        std::cout << "visits: " << visits << ", blocks with a dead end: " << dead_ends.size() << std::endl;
+        std::sort(dead_ends.begin(), dead_ends.end(), [](const std::pair<uint32_t, int> &a, const std::pair<uint32_t, int> &b) {
+            return a.first > b.first || (a.first == b.first && a.second < b.second);
+        });
+        for (long i = 0; i < top && i < (long) dead_ends.size(); i++) {
+            int x = dead_ends[i].second % stats.width(), y = dead_ends[i].second / stats.width();
+            std::cout << "  (" << x << ", " << y << "): " << dead_ends[i].first << " dead ends, "
+                      << stats.visits(x, y) << " visits" << std::endl;
+        }
+
+        if (!grid.empty()) {
+            for (int y = 0; y < stats.height(); y++) {
+                for (int x = 0; x < stats.width(); x++) {
+                    std::cout << (grid == "visits" ? stats.visits(x, y) : stats.dead_ends(x, y)) << ",";
+                }
+                std::cout << std::endl;
+            }
+        }
+    } catch (std::exception &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
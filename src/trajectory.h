@@ -0,0 +1,479 @@
+#ifndef __TRAJECTORY__H
+#define __TRAJECTORY__H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "maze_grid.h"
+#include "seen_map.h"
+#include "wander_policy.h"
+
+namespace
+{
+
+    //! The binary trajectory format shared by TrajectoryRecorder and TrajectoryReplay.
+    //!
+    //! A file starts with the magic "WTR1" and three uint32: the maze width and height and the keyframe
+    //! interval. Then comes one record per step, a step being a Checking decision or a block passed in
+    //! fast forward. A step is a single byte followed by the number of ticks since the previous step as a
+    //! varint (LEB128). The byte holds the heading in bits 0-1, the free space mask seen by the robot in
+    //! bits 2-4 and the action in bits 5-6. The block is not stored: it follows from the previous step.
+    //!
+    //! A byte with bit 7 set is a marker instead. POSE gives the pose as three varints, and it is written
+    //! whenever the robot is not where the previous steps took it (start, restart, player control).
+    //! RESTART clears the visit map. KEYFRAME stores the step number, the tick, the pose, and the visit
+    //! map with its zero runs collapsed. A keyframe is written every interval steps, and the file is
+    //! flushed after it.
+    //!
+    //! When the recorder is closed it appends an index of the keyframes. Each entry is a uint64 step and a
+    //! uint64 offset. Then comes the uint64 number of entries and the magic "WTRX". A file without the
+    //! index (the process was killed) is still readable, the index is then rebuilt with one pass.
+    namespace trajectory
+    {
+        constexpr char MAGIC[4] = { 'W', 'T', 'R', '1' };
+        constexpr char INDEX_MAGIC[4] = { 'W', 'T', 'R', 'X' };
+        constexpr size_t HEADER_SIZE = 16;
+        constexpr size_t INDEX_ENTRY_SIZE = 16;
+        constexpr size_t INDEX_TRAILER_SIZE = 12;
+
+        enum Action { MOVE = 0, TURN_RIGHT = 1, TURN_LEFT = 2, PASS = 3 };
+        enum Marker { KEYFRAME = 0x80, POSE = 0x81, RESTART = 0x82 };
+
+        inline void put_varint(std::vector<char> &out, uint64_t v) {
+            while (v >= 0x80) {
+                out.push_back((char) (v | 0x80));
+                v >>= 7;
+            }
+            out.push_back((char) v);
+        }
+
+        //! \return false when the value runs past the end.
+        inline bool get_varint(const unsigned char *&p, const unsigned char *end, uint64_t &v) {
+            v = 0;
+            for (int shift = 0; p < end && shift < 64; shift += 7) {
+                unsigned char b = *p++;
+                v |= (uint64_t) (b & 0x7f) << shift;
+                if (!(b & 0x80)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        inline void put_u32(std::vector<char> &out, uint32_t v) {
+            for (int i = 0; i < 4; i++) {
+                out.push_back((char) (v >> 8 * i));
+            }
+        }
+
+        inline uint64_t get_u64(const unsigned char *p) {
+            uint64_t v = 0;
+            for (int i = 7; i >= 0; i--) {
+                v = v << 8 | p[i];
+            }
+            return v;
+        }
+
+        //! Applies the pose change of a step, the same one the robot makes.
+        inline void apply(GridPose &pose, int heading, int action) {
+            if (action == TURN_RIGHT || action == TURN_LEFT) {
+                pose.heading = (heading + (action == TURN_RIGHT ? 1 : 3)) & 3;
+            } else {
+                pose.heading = heading;
+                pose.x += MazeGrid::dx(heading);
+                pose.y += MazeGrid::dy(heading);
+            }
+        }
+    }
+
+    //! Appends the steps of one robot to a trajectory file, see the trajectory namespace for the format.
+    //!
+    //! A step costs one byte plus the tick delta (usually one byte) in a memory buffer, which is written out
+    //! after every keyframe. The recorder follows the pose through the steps, so it only writes a POSE
+    //! when the robot is found somewhere else. It never reads the walls.
+    class TrajectoryRecorder
+    {
+    public:
+        //! \param path (string) the file to create, an existing one is replaced.
+        //! \param width (int) number of columns of the maze.
+        //! \param height (int) number of rows of the maze.
+        //! \param interval (int) steps between two keyframes, 0 for max(1024, number of blocks), so that
+        //! the keyframes stay under about two bytes per step.
+        TrajectoryRecorder(const std::string &path, int width, int height, int interval = 0)
+            : out(path, std::ios::binary | std::ios::trunc), width(width), height(height),
+              interval(interval > 0 ? interval : std::max(1024, width * height)), offset(0), steps(0),
+              last_keyframe(0), now(0), last_tick(0), at({ 0, 0, 0, false }), keyframes(0) {
+            if (!out) {
+                throw std::runtime_error("could not create " + path);
+            }
+            buffer.insert(buffer.end(), trajectory::MAGIC, trajectory::MAGIC + 4);
+            trajectory::put_u32(buffer, width);
+            trajectory::put_u32(buffer, height);
+            trajectory::put_u32(buffer, this->interval);
+        }
+
+        TrajectoryRecorder(const TrajectoryRecorder &) = delete;
+        TrajectoryRecorder &operator=(const TrajectoryRecorder &) = delete;
+
+        //! Writes the keyframe index at the end of the file.
+        ~TrajectoryRecorder() {
+            for (auto &k : index) {
+                put_u64(k.first);
+                put_u64(k.second);
+            }
+            put_u64(index.size());
+            buffer.insert(buffer.end(), trajectory::INDEX_MAGIC, trajectory::INDEX_MAGIC + 4);
+            flush();
+        }
+
+        //! Advances the clock by one tick.
+        void tick() { now++; }
+
+        //! Records a Checking decision.
+        //! \param pose (GridPose) where the decision was made.
+        //! \param open (int) the free space mask the decision was made with.
+        //! \param d (Decision) a move ahead or a quarter turn.
+        //! \param seen (SeenMap) the visit map before the decision, copied into the keyframes.
+        void decided(const GridPose &pose, int open, const Decision &d, const SeenMap &seen) {
+            int action = d.kind == Decision::MOVE ? trajectory::MOVE : d.rate > 0 ? trajectory::TURN_RIGHT : trajectory::TURN_LEFT;
+            step(pose, pose.heading, open, action, seen);
+        }
+
+        //! Records a block passed in fast forward.
+        //! \param pose (GridPose) the block being left.
+        //! \param out (int) the heading it is left with.
+        void passed(const GridPose &pose, int out, const SeenMap &seen) {
+            step(pose, out, 0, trajectory::PASS, seen);
+        }
+
+        //! Records that the visit map was cleared.
+        void restarted() {
+            buffer.push_back((char) trajectory::RESTART);
+            at.valid = false; // The next step writes where the robot starts from
+        }
+
+        long recorded_steps() const { return steps; }
+        long written_bytes() const { return offset + buffer.size(); }
+
+    private:
+        void step(const GridPose &pose, int heading, int open, int action, const SeenMap &seen) {
+            if (!at.valid || at.x != pose.x || at.y != pose.y || at.heading != pose.heading) {
+                at = { pose.x, pose.y, pose.heading, true };
+                buffer.push_back((char) trajectory::POSE);
+                trajectory::put_varint(buffer, zigzag(pose.x));
+                trajectory::put_varint(buffer, zigzag(pose.y));
+                trajectory::put_varint(buffer, pose.heading & 3);
+            }
+            if (keyframes == 0 || steps - last_keyframe >= interval) {
+                keyframe(seen);
+            }
+            buffer.push_back((char) ((heading & 3) | (open & 7) << 2 | action << 5));
+            trajectory::put_varint(buffer, now - last_tick);
+            last_tick = now;
+            trajectory::apply(at, heading, action);
+            steps++;
+        }
+
+        void keyframe(const SeenMap &seen) {
+            index.push_back({ (uint64_t) steps, (uint64_t) written_bytes() });
+            buffer.push_back((char) trajectory::KEYFRAME);
+            trajectory::put_varint(buffer, steps);
+            trajectory::put_varint(buffer, now);
+            trajectory::put_varint(buffer, zigzag(at.x));
+            trajectory::put_varint(buffer, zigzag(at.y));
+            trajectory::put_varint(buffer, at.heading & 3);
+            for (int i = 0, blocks = width * height; i < blocks;) {
+                int v = seen.get_value(i % width, i / width);
+                if (v != 0) {
+                    trajectory::put_varint(buffer, v);
+                    i++;
+                    continue;
+                }
+                int run = 0;
+                for (; i < blocks && seen.get_value(i % width, i / width) == 0; i++) {
+                    run++;
+                }
+                buffer.push_back(0);
+                trajectory::put_varint(buffer, run);
+            }
+            last_keyframe = steps;
+            last_tick = now;
+            keyframes++;
+            flush();
+        }
+
+        void flush() {
+            out.write(buffer.data(), buffer.size());
+            out.flush();
+            offset += buffer.size();
+            buffer.clear();
+        }
+
+        void put_u64(uint64_t v) {
+            for (int i = 0; i < 8; i++) {
+                buffer.push_back((char) (v >> 8 * i));
+            }
+        }
+
+        static uint64_t zigzag(int v) { return (uint64_t) (((int64_t) v << 1) ^ ((int64_t) v >> 63)); }
+
+        std::ofstream out;
+        int width;
+        int height;
+        int interval;
+        std::vector<char> buffer;   //!< bytes not written yet
+        long offset;                //!< bytes already written
+        long steps;
+        long last_keyframe;
+        uint64_t now;
+        uint64_t last_tick;
+        GridPose at;                //!< where the recorded steps have taken the robot
+        long keyframes;
+        std::vector<std::pair<uint64_t, uint64_t>> index; //!< step and offset of every keyframe
+    };
+
+    //! Reads a trajectory file through a read-only memory map.
+    //!
+    //! The replay keeps a cursor with the pose, the tick and the visit map the robot had before the step
+    //! under it. seek() jumps to any step with a binary search of the keyframe index, then decodes at
+    //! most one keyframe interval of steps. next() reads the steps one by one from there.
+    class TrajectoryReplay
+    {
+    public:
+        //! One decoded step.
+        struct Step
+        {
+            GridPose pose;  //!< the pose before the step
+            int heading;    //!< the heading of the action, the new heading for PASS steps
+            int open;       //!< free space mask seen by the robot, 0 for PASS steps
+            int action;     //!< a trajectory::Action
+            uint64_t tick;
+        };
+
+        //! \param path (string) the trajectory file.
+        TrajectoryReplay(const std::string &path) : data(nullptr), size(0), map(1, 1) {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::runtime_error("could not open " + path);
+            }
+            struct stat st;
+            if (fstat(fd, &st) == 0 && st.st_size > 0) {
+                size = st.st_size;
+                void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                data = p == MAP_FAILED ? nullptr : (const unsigned char *) p;
+            }
+            ::close(fd);
+            if (data == nullptr || size < trajectory::HEADER_SIZE || std::memcmp(data, trajectory::MAGIC, 4) != 0) {
+                release();
+                throw std::runtime_error(path + " is not a trajectory file");
+            }
+            map_width = read_u32(4);
+            map_height = read_u32(8);
+            interval = read_u32(12);
+            map.resize(map_width, map_height);
+            end = data + size;
+            index_entries = nullptr;
+            index_count = 0;
+            if (size >= trajectory::HEADER_SIZE + trajectory::INDEX_TRAILER_SIZE
+                && std::memcmp(end - 4, trajectory::INDEX_MAGIC, 4) == 0) {
+                uint64_t count = trajectory::get_u64(end - trajectory::INDEX_TRAILER_SIZE);
+                size_t bytes = count * trajectory::INDEX_ENTRY_SIZE + trajectory::INDEX_TRAILER_SIZE;
+                if (count < size && bytes <= size - trajectory::HEADER_SIZE) {
+                    end -= bytes;
+                    index_entries = end;
+                    index_count = count;
+                }
+            }
+            rewind();
+            if (index_entries == nullptr) {
+                // No index, killed before closing: read everything once to find the keyframes
+                Step s;
+                while (next(s)) {
+                }
+                rewind();
+            } else {
+                seek(~0ull); // Counts the steps after the last keyframe
+                rewind();
+            }
+        }
+
+        TrajectoryReplay(const TrajectoryReplay &) = delete;
+        TrajectoryReplay &operator=(const TrajectoryReplay &) = delete;
+
+        ~TrajectoryReplay() { release(); }
+
+        int width() const { return map_width; }
+        int height() const { return map_height; }
+        //! \return the number of steps in the file.
+        uint64_t steps() const { return total; }
+        int keyframe_interval() const { return interval; }
+        size_t keyframes() const { return index_entries != nullptr ? index_count : rebuilt.size(); }
+        //! \return false when the index had to be rebuilt.
+        bool indexed() const { return index_entries != nullptr; }
+        //! \return the size of the file.
+        size_t bytes() const { return size; }
+
+        //! The state of the cursor: the robot before the step under it.
+        const GridPose &pose() const { return at; }
+        const SeenMap &seen() const { return map; }
+        uint64_t step() const { return current; }
+        uint64_t tick() const { return now; }
+
+        //! Moves the cursor to the first step.
+        void rewind() {
+            p = data + trajectory::HEADER_SIZE;
+            at = { 0, 0, MazeGrid::RIGHT, false };
+            map.reset_map();
+            current = now = 0;
+        }
+
+        //! Moves the cursor to the given step, or to the end when there are fewer steps.
+        void seek(uint64_t target) {
+            size_t n = keyframes();
+            size_t lo = 0, hi = n;
+            while (lo < hi) { // First keyframe after the target
+                size_t mid = (lo + hi) / 2;
+                if (keyframe_step(mid) <= target) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            bool ahead = current <= target && (lo == 0 || current >= keyframe_step(lo - 1));
+            if (!ahead && lo == 0) {
+                rewind();
+            } else if (!ahead) {
+                p = data + keyframe_offset(lo - 1); // Loaded by peek()
+            }
+            Step s;
+            while (peek() && current < target && decode(s)) {
+            }
+        }
+
+        //! Reads the step under the cursor and moves past it.
+        //! \return false at the end of the file.
+        bool next(Step &s) {
+            return peek() && decode(s);
+        }
+
+        //! Applies the markers before the step under the cursor, so that pose() and seen() are the state
+        //! the step is taken from.
+        //! \return false at the end of the file.
+        bool peek() {
+            uint64_t v[5];
+            while (p < end && (*p & 0x80)) {
+                const unsigned char *marker = p++;
+                if (*marker == trajectory::RESTART) {
+                    map.reset_map();
+                } else if (*marker == trajectory::POSE) {
+                    if (!read(v, 3)) {
+                        return false;
+                    }
+                    at = { unzigzag(v[0]), unzigzag(v[1]), (int) (v[2] & 3), true };
+                } else if (*marker == trajectory::KEYFRAME) {
+                    if (!read(v, 5)) {
+                        return false;
+                    }
+                    if (index_entries == nullptr && (rebuilt.empty() || rebuilt.back().first < v[0])) {
+                        rebuilt.push_back({ v[0], (uint64_t) (marker - data) });
+                    }
+                    current = v[0];
+                    now = v[1];
+                    at = { unzigzag(v[2]), unzigzag(v[3]), (int) (v[4] & 3), true };
+                    for (int i = 0, blocks = map_width * map_height; i < blocks;) {
+                        uint64_t value, run = 1;
+                        if (!trajectory::get_varint(p, end, value) || (value == 0 && !trajectory::get_varint(p, end, run))) {
+                            return false;
+                        }
+                        for (uint64_t r = 0; r < run && i < blocks; r++, i++) {
+                            map.set_value(i % map_width, i / map_width, (int) value);
+                        }
+                    }
+                } else {
+                    p = end; // Unknown marker, the rest can not be trusted
+                }
+            }
+            return p < end;
+        }
+
+    private:
+        bool decode(Step &s) {
+            unsigned char b = *p++;
+            uint64_t delta;
+            if (!trajectory::get_varint(p, end, delta)) {
+                p = end; // Cut in the middle of the step
+                return false;
+            }
+            s.pose = at;
+            s.heading = b & 3;
+            s.open = b >> 2 & 7;
+            s.action = b >> 5 & 3;
+            s.tick = now += delta;
+            if (s.action == trajectory::MOVE || s.action == trajectory::PASS) {
+                map.set_to_visited(at.x, at.y); // The block being left, like Moving
+            }
+            trajectory::apply(at, s.heading, s.action);
+            current++;
+            total = std::max(total, current);
+            return true;
+        }
+
+        bool read(uint64_t *v, int n) {
+            for (int i = 0; i < n; i++) {
+                if (!trajectory::get_varint(p, end, v[i])) {
+                    p = end;
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        uint64_t keyframe_step(size_t i) const {
+            return index_entries != nullptr ? trajectory::get_u64(index_entries + i * trajectory::INDEX_ENTRY_SIZE) : rebuilt[i].first;
+        }
+        uint64_t keyframe_offset(size_t i) const {
+            return index_entries != nullptr ? trajectory::get_u64(index_entries + i * trajectory::INDEX_ENTRY_SIZE + 8) : rebuilt[i].second;
+        }
+
+        uint32_t read_u32(size_t at) const {
+            return data[at] | data[at + 1] << 8 | data[at + 2] << 16 | (uint32_t) data[at + 3] << 24;
+        }
+
+        static int unzigzag(uint64_t v) { return (int) ((int64_t) (v >> 1) ^ -(int64_t) (v & 1)); }
+
+        void release() {
+            if (data != nullptr) {
+                munmap((void *) data, size);
+                data = nullptr;
+            }
+        }
+
+        const unsigned char *data;
+        size_t size;
+        const unsigned char *end;           //!< end of the steps, where the index starts
+        const unsigned char *index_entries; //!< null when the file has no index
+        uint64_t index_count;
+        std::vector<std::pair<uint64_t, uint64_t>> rebuilt; //!< the keyframes found by reading, without an index
+        int map_width;
+        int map_height;
+        int interval;
+        uint64_t total = 0;
+
+        const unsigned char *p; //!< the cursor
+        GridPose at;
+        SeenMap map;
+        uint64_t current;
+        uint64_t now;
+    };
+
+}
+
+#endif
@@ -0,0 +1,240 @@
+#ifndef __VISIT_STATS__H
+#define __VISIT_STATS__H
+
+#include <string>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+
+    //! The layout of a visit statistics file, shared by VisitStats and the offline tools.
+    //!
+    //! The file is a fixed-size image of the counters, mapped into memory by every process that uses it,
+    //! so it needs no parsing. All the integers are little-endian. The header is HEADER_SIZE bytes:
+    //! the magic "WVS1", the uint32 maze width and height, the uint32 header size, then the uint64
+    //! episodes, episodes that got out, sum of their steps-to-exit, and fewest steps-to-exit (0 before the
+    //! first exit). Then come BUCKETS uint64 counting the exits by steps-to-exit, bucket i holding
+    //! [2^(i-1), 2^i) steps. Then one CELL_SIZE record per block in row-major order: the uint32 visits
+    //! and the uint32 dead end hits (the robot found no way ahead, on the right or on the left). The
+    //! counters wrap around after 2^32.
+    namespace visit_stats
+    {
+        constexpr char MAGIC[4] = { 'W', 'V', 'S', '1' };
+        constexpr size_t HEADER_SIZE = 64;
+        constexpr int BUCKETS = 32;
+        constexpr size_t CELLS_OFFSET = HEADER_SIZE + BUCKETS * 8;
+        constexpr size_t CELL_SIZE = 8;
+
+        enum Field { EPISODES = 16, EXITS = 24, EXIT_STEPS = 32, MIN_EXIT_STEPS = 40 };
+
+        //! \return the size of the file of a width x height maze.
+        inline size_t file_size(int width, int height) {
+            return CELLS_OFFSET + (size_t) width * height * CELL_SIZE;
+        }
+    }
+
+    //! Visit statistics accumulated over every episode of every run, in a memory-mapped file.
+    //!
+    //! Unlike the SeenMap, which the robot clears on every restart, the counters live as long as the file.
+    //! Every update is one relaxed atomic add on the mapping, so robots on several threads, or several
+    //! processes mapping the same file, never wait on a lock or on the disk. The kernel writes the pages
+    //! back on its own. A file opened read-only, e.g. by wander_stats, can not be updated.
+    class VisitStats
+    {
+    public:
+        //! Opens a file for updates, created with zeroed counters when it does not exist.
+        //! \param path (string) the statistics file.
+        //! \param width (int) number of columns of the maze, must match an existing file.
+        //! \param height (int) number of rows of the maze.
+        VisitStats(const std::string &path, int width, int height)
+            : data(nullptr), size(visit_stats::file_size(width, height)), map_width(width), map_height(height), writable(true) {
+            int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+            if (fd < 0) {
+                throw std::runtime_error("could not open " + path);
+            }
+            struct stat st;
+            bool created = fstat(fd, &st) == 0 && st.st_size == 0;
+            if (created && ftruncate(fd, size) != 0) {
+                ::close(fd);
+                throw std::runtime_error("could not create " + path);
+            }
+            if (created || (fstat(fd, &st) == 0 && (size_t) st.st_size == size)) {
+                void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                data = p == MAP_FAILED ? nullptr : (unsigned char *) p;
+            }
+            ::close(fd);
+            if (data != nullptr && created) {
+                std::memcpy(data, visit_stats::MAGIC, 4);
+                put_u32(4, width);
+                put_u32(8, height);
+                put_u32(12, visit_stats::HEADER_SIZE);
+            }
+            if (data == nullptr || std::memcmp(data, visit_stats::MAGIC, 4) != 0 || read_u32(4) != (uint32_t) width
+                || read_u32(8) != (uint32_t) height) {
+                release();
+                throw std::runtime_error(path + " is not a visit statistics file of a " + std::to_string(width) + "x"
+                                         + std::to_string(height) + " maze");
+            }
+        }
+
+        //! Opens a file read-only, the maze size comes from its header.
+        //! \param path (string) the statistics file.
+        VisitStats(const std::string &path) : data(nullptr), size(0), map_width(0), map_height(0), writable(false) {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::runtime_error("could not open " + path);
+            }
+            struct stat st;
+            if (fstat(fd, &st) == 0 && (size_t) st.st_size >= visit_stats::CELLS_OFFSET) {
+                size = st.st_size;
+                void *p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+                data = p == MAP_FAILED ? nullptr : (unsigned char *) p;
+            }
+            ::close(fd);
+            if (data == nullptr || std::memcmp(data, visit_stats::MAGIC, 4) != 0
+                || visit_stats::file_size(read_u32(4), read_u32(8)) != size) {
+                release();
+                throw std::runtime_error(path + " is not a visit statistics file");
+            }
+            map_width = read_u32(4);
+            map_height = read_u32(8);
+        }
+
+        VisitStats(const VisitStats &) = delete;
+        VisitStats &operator=(const VisitStats &) = delete;
+
+        ~VisitStats() { release(); }
+
+        int width() const { return map_width; }
+        int height() const { return map_height; }
+        bool is_writable() const { return writable; }
+
+        //! Counts a step out of block (x, y), the block the SeenMap marks as visited.
+        void visited(int x, int y) {
+            if (in_bounds(x, y)) {
+                __atomic_fetch_add(cell(x, y), 1, __ATOMIC_RELAXED);
+            }
+        }
+
+        //! Counts a dead end found in block (x, y).
+        void dead_end(int x, int y) {
+            if (in_bounds(x, y)) {
+                __atomic_fetch_add(cell(x, y) + 1, 1, __ATOMIC_RELAXED);
+            }
+        }
+
+        //! Counts a finished episode.
+        //! \param exited (bool) true when the robot got out.
+        //! \param steps (long) the steps of the episode.
+        void episode_end(bool exited, long steps) {
+            __atomic_fetch_add(field(visit_stats::EPISODES), 1, __ATOMIC_RELAXED);
+            if (!exited) {
+                return;
+            }
+            __atomic_fetch_add(field(visit_stats::EXITS), 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(field(visit_stats::EXIT_STEPS), steps, __ATOMIC_RELAXED);
+            int bucket = steps <= 0 ? 0 : 64 - __builtin_clzll(steps);
+            __atomic_fetch_add(histogram() + (bucket < visit_stats::BUCKETS ? bucket : visit_stats::BUCKETS - 1), 1, __ATOMIC_RELAXED);
+            uint64_t *least = field(visit_stats::MIN_EXIT_STEPS);
+            uint64_t current = __atomic_load_n(least, __ATOMIC_RELAXED);
+            while ((current == 0 || (uint64_t) steps < current)
+                   && !__atomic_compare_exchange_n(least, &current, steps, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            }
+        }
+
+        //! \return the steps out of block (x, y) over every episode, 0 outside of the maze.
+        uint32_t visits(int x, int y) const {
+            return in_bounds(x, y) ? __atomic_load_n(cell(x, y), __ATOMIC_RELAXED) : 0;
+        }
+
+        //! \return the dead ends found in block (x, y) over every episode, 0 outside of the maze.
+        uint32_t dead_ends(int x, int y) const {
+            return in_bounds(x, y) ? __atomic_load_n(cell(x, y) + 1, __ATOMIC_RELAXED) : 0;
+        }
+
+        uint64_t episodes() const { return load(visit_stats::EPISODES); }
+        uint64_t exits() const { return load(visit_stats::EXITS); }
+        uint64_t exit_steps() const { return load(visit_stats::EXIT_STEPS); }
+        //! \return the fewest steps-to-exit, 0 before the first exit.
+        uint64_t min_exit_steps() const { return load(visit_stats::MIN_EXIT_STEPS); }
+        //! \return the exits that took [2^(i-1), 2^i) steps.
+        uint64_t exit_histogram(int i) const {
+            return __atomic_load_n(histogram() + i, __ATOMIC_RELAXED);
+        }
+
+    private:
+        bool in_bounds(int x, int y) const {
+            return (unsigned) x < (unsigned) map_width && (unsigned) y < (unsigned) map_height;
+        }
+
+        uint32_t *cell(int x, int y) const {
+            return (uint32_t *) (data + visit_stats::CELLS_OFFSET + ((size_t) y * map_width + x) * visit_stats::CELL_SIZE);
+        }
+        uint64_t *field(visit_stats::Field f) const { return (uint64_t *) (data + f); }
+        uint64_t *histogram() const { return (uint64_t *) (data + visit_stats::HEADER_SIZE); }
+        uint64_t load(visit_stats::Field f) const { return __atomic_load_n(field(f), __ATOMIC_RELAXED); }
+
+        uint32_t read_u32(size_t at) const {
+            return data[at] | data[at + 1] << 8 | data[at + 2] << 16 | (uint32_t) data[at + 3] << 24;
+        }
+        void put_u32(size_t at, uint32_t v) {
+            for (int i = 0; i < 4; i++) {
+                data[at + i] = (unsigned char) (v >> 8 * i);
+            }
+        }
+
+        void release() {
+            if (data != nullptr) {
+                munmap(data, size);
+                data = nullptr;
+            }
+        }
+
+        unsigned char *data;
+        size_t size;
+        int map_width;
+        int map_height;
+        bool writable;
+    };
+
+    //! The updates one robot makes to a VisitStats shared with the others: it counts the steps of its
+    //! current episode, so the episode is added with its steps-to-exit when it ends.
+    class VisitStatsFeed
+    {
+    public:
+        VisitStatsFeed(VisitStats &stats) : stats(stats), steps(0) {}
+
+        //! The robot left block (x, y).
+        void stepped(int x, int y) {
+            stats.visited(x, y);
+            steps++;
+        }
+
+        //! The robot found no way on in block (x, y).
+        void dead_end(int x, int y) { stats.dead_end(x, y); }
+
+        //! Ends the current episode, an episode without any step is ignored.
+        //! \param exited (bool) true when the robot got out, false when it was restarted.
+        void episode_end(bool exited) {
+            if (steps == 0) {
+                return;
+            }
+            stats.episode_end(exited, steps);
+            steps = 0;
+        }
+
+        VisitStats &stats;
+
+    private:
+        long steps;
+    };
+
+}
+
+#endif
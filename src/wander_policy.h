@@ -0,0 +1,217 @@
+#ifndef __WANDER_POLICY__H
+#define __WANDER_POLICY__H
+
+#include <array>
+#include <math.h>
+#include <cstdint>
+#include <climits>
+#include "seen_map.h"
+#include "maze_grid.h"
+#include "grid_geometry.h"
+
+namespace
+{
+
+    //! The outcome of one Checking decision, either move to a neighbouring block or rotate in place.
+    struct Decision
+    {
+        enum Kind { MOVE, ROTATE };
+
+        //! Move to the block located at (x, y).
+        static Decision move(int x, int y) { return { MOVE, x, y, 0 }; }
+
+        //! Rotate 90 degrees, clockwise when rate is 1, counter-clockwise when rate is -1.
+        static Decision rotate(int rate) { return { ROTATE, 0, 0, rate }; }
+
+        Kind kind;
+        int x;
+        int y;
+        int rate;
+    };
+
+    //! Bits of the neighbour ordering, set when the first block has been visited no more than the second.
+    enum Ordering { FRONT_LE_RIGHT = 1, FRONT_LE_LEFT = 2, RIGHT_LE_LEFT = 4 };
+
+    //! One entry of the decision table: a step of (dx, dy) when rate is 0, a rotation otherwise.
+    struct DecisionEntry
+    {
+        signed char dx;
+        signed char dy;
+        signed char rate;
+    };
+
+    //! The least visited rule for one combination of free space mask and neighbour ordering.
+    //! Ties go to the front, then to the right, like the original if ladder.
+    //! \return 0 to move forward, 1 to turn right, -1 to turn left.
+    constexpr int least_visited_turn(int open, int order) {
+        bool f_r = order & FRONT_LE_RIGHT, f_l = order & FRONT_LE_LEFT, r_l = order & RIGHT_LE_LEFT;
+        switch (open) {
+            case OPEN_FRONT | OPEN_RIGHT | OPEN_LEFT:
+                return f_r && f_l ? 0 : !f_r && r_l ? 1 : -1;
+            case OPEN_FRONT | OPEN_RIGHT:
+                return f_r ? 0 : 1;
+            case OPEN_FRONT | OPEN_LEFT:
+                return f_l ? 0 : -1;
+            case OPEN_RIGHT | OPEN_LEFT:
+                return r_l ? 1 : -1;
+            case OPEN_FRONT:
+                return 0;
+            case OPEN_LEFT:
+                return -1;
+            default: // Only the right is free, or a dead end
+                return 1;
+        }
+    }
+
+    //! Builds the decision table indexed by heading x free space mask x neighbour ordering.
+    constexpr std::array<DecisionEntry, 4 * 8 * 8> make_decision_table() {
+        std::array<DecisionEntry, 4 * 8 * 8> table = {};
+        for (int heading = 0; heading < 4; heading++) {
+            for (int open = 0; open < 8; open++) {
+                for (int order = 0; order < 8; order++) {
+                    int turn = least_visited_turn(open, order);
+                    DecisionEntry &entry = table[(heading * 8 + open) * 8 + order];
+                    entry.dx = turn == 0 ? DIRECTION_X[heading] : 0;
+                    entry.dy = turn == 0 ? DIRECTION_Y[heading] : 0;
+                    entry.rate = turn;
+                }
+            }
+        }
+        return table;
+    }
+
+    constexpr std::array<DecisionEntry, 4 * 8 * 8> DECISION_TABLE = make_decision_table();
+
+    //! Turn needed to face the exit, indexed by (exit heading - heading) & 3, 0 means move out.
+    constexpr int EXIT_TURN[4] = { 0, 1, 1, -1 };
+
+    //! The least visited decision as a table lookup.
+    //! \param x (int) current column.
+    //! \param y (int) current row.
+    //! \param heading (int) current heading, 0 right, 1 down, 2 left, 3 up.
+    //! \param open (int) free space mask made of OpenSide bits.
+    //! \param seen (int[4]) visited times of the blocks on the right, below, on the left and above.
+    inline Decision decide(int x, int y, int heading, int open, const int seen[4]) {
+        int front = seen[heading];
+        int right = seen[(heading + 1) & 3];
+        int left = seen[(heading + 3) & 3];
+        int order = (front <= right) | (front <= left) << 1 | (right <= left) << 2;
+        const DecisionEntry &entry = DECISION_TABLE[(heading * 8 + open) * 8 + order];
+        return { entry.rate == 0 ? Decision::MOVE : Decision::ROTATE, x + entry.dx, y + entry.dy, entry.rate };
+    }
+
+    //! The least visited decision with ties broken at random instead of front first, then right.
+    //! Without ties it is the same decision as decide().
+    //! \param state (uint64_t) xorshift state of the robot, must not be 0.
+    inline Decision decide_random_ties(int x, int y, int heading, int open, const int seen[4], uint64_t &state) {
+        static const int sides[3] = { OPEN_FRONT, OPEN_RIGHT, OPEN_LEFT };
+        static const int turns[3] = { 0, 1, -1 };
+        int tied[3], count = 0, least = INT_MAX;
+        for (int i = 0; i < 3; i++) {
+            if (!(open & sides[i])) {
+                continue;
+            }
+            int value = seen[(heading + turns[i] + 4) & 3];
+            if (value < least) {
+                least = value;
+                count = 0;
+            }
+            if (value == least) {
+                tied[count++] = turns[i];
+            }
+        }
+        if (count == 0) {
+            return Decision::rotate(1); // Dead end
+        }
+        int turn = tied[0];
+        if (count > 1) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            turn = tied[state % count];
+        }
+        return turn == 0 ? Decision::move(x + DIRECTION_X[heading], y + DIRECTION_Y[heading]) : Decision::rotate(turn);
+    }
+
+    //! Where the robot leaves the maze: a boundary block and the heading of its open outer edge.
+    //! Defaults to the bottom right block of the original 7x7 maze.
+    struct MazeExit
+    {
+        int x = 6;
+        int y = 6;
+        int heading = MazeGrid::DOWN;
+
+        //! \return the exit of the grid, or the default one when the grid has no open outer edge.
+        static MazeExit of(const MazeGrid &grid) {
+            MazeExit exit;
+            grid.find_exit(exit.x, exit.y, exit.heading);
+            return exit;
+        }
+    };
+
+    //! The pose of a robot on the grid: its block and one of the four headings.
+    //!
+    //! The autonomous modes keep it up to date as they move and rotate, and derive the physics pose
+    //! from it for rendering, so decisions never read back the floating point position and angle.
+    struct GridPose
+    {
+        int x = 0;
+        int y = 0;
+        int heading = MazeGrid::RIGHT;
+        bool valid = false; //!< false when the physics pose has to be read back, e.g. after the player drove
+
+        //! Turns 90 degrees clockwise when rate is 1, counter-clockwise when rate is -1.
+        void rotate(int rate) { heading = (heading + rate) & 3; }
+    };
+
+    //! Finds the block the robot is in and where it is heading from the physics pose, only needed to
+    //! take over a robot that was not on the grid, e.g. driven by the player.
+    //! \param body anything that provides position() (with .x and .y) and angle()
+    //! \param cur_x (int) receives the column.
+    //! \param cur_y (int) receives the row.
+    //! \param heading (int) receives the heading, 0 right, 1 down, 2 left, 3 up.
+    //! \param geometry (GridGeometry) the layout of the maze, the shipped one by default.
+    template <class Body>
+    void grid_pose(Body &body, int &cur_x, int &cur_y, int &heading, const GridGeometry &geometry = GridGeometry())
+    {
+        auto pos = body.position();
+        geometry.block_of(pos.x, pos.y, cur_x, cur_y); // The closest block when the robot is just outside
+        // The closest of the four headings, whatever the number of turns
+        heading = (int) (std::lround(body.angle() / M_PI_2) & 3);
+    }
+
+    //! The wander policy used by the Checking state: go to the least visited block among the
+    //! block in front, the block on the right and the block on the left.
+    //!
+    //! The policy only talks to the robot through its grid pose and open_sides(), so it can be
+    //! driven by the enviro controller or by the grid based body of the headless simulator.
+    //! The free space and each neighbour count are read once per decision.
+    //! \param body anything that provides open_sides(x, y, heading) returning OpenSide bits
+    //! \param pose (GridPose) the block and heading of the robot.
+    //! \param seen the visit counts the robot uses, a SeenMap or anything that provides neighbours(x, y, values)
+    //! \param exit (MazeExit) the block and heading the robot leaves the maze from.
+    //! \param ties (uint64_t) random state to break ties with, null to break them front first, then right.
+    //! \return the next movement of the robot
+    template <class Body, class Seen>
+    Decision wander_decision(Body &body, const GridPose &pose, const Seen &seen, const MazeExit &exit = MazeExit(),
+                             uint64_t *ties = nullptr)
+    {
+        int cur_x = pose.x, cur_y = pose.y, heading = pose.heading;
+        // robot at maze exit, face the opening and move to the boundry
+        if (cur_x == exit.x && cur_y == exit.y) {
+            int turn = EXIT_TURN[(exit.heading - heading) & 3];
+            return turn == 0 ? Decision::move(cur_x + MazeGrid::dx(exit.heading), cur_y + MazeGrid::dy(exit.heading))
+                             : Decision::rotate(turn);
+        }
+        int open = body.open_sides(cur_x, cur_y, heading);
+        int counts[4];
+        seen.neighbours(cur_x, cur_y, counts);
+        if (ties != nullptr) {
+            return decide_random_ties(cur_x, cur_y, heading, open, counts, *ties);
+        }
+        return decide(cur_x, cur_y, heading, open, counts);
+    }
+
+}
+
+#endif
@@ -7,70 +7,35 @@
 #include <vector>
 #include <json/json.h>
 #include <climits>
+#include <atomic>
+#include <algorithm>
+#include "seen_map.h"
+#include "maze_grid.h"
+#include "maze_solver.h"
+#include "wander_policy.h"
+#include "telemetry.h"
+#include "corridors.h"
+#include "trajectory.h"
+#include "policies.h"
+#include "headless.h"
+#include "heatmap_stream.h"
+#include "player_input.h"
+#include "visit_stats.h"
+#include "grid_geometry.h"
+#include "planner.h"
+#include "event_channel.h"
 
 namespace
 {
 
     using namespace enviro;
 
-    //! A static class that represents a 7x7 matrix that keeps track of how many times each block has been visited.
-
-    //! An example shows the robot has visited (0,0) 1 time, (0,1) 1 time, (0,2) 1 time and (0,3) one time
-    //! 1, 1, 1, 1, 0, 0, 0
-    //! 0, 0, 0, 0, 0, 0, 0
-    //! 0, 0, 0, 0, 0, 0, 0
-    //! 0, 0, 0, 0, 0, 0, 0
-    //! 0, 0, 0, 0, 0, 0, 0
-    //! 0, 0, 0, 0, 0, 0, 0
-    //! 0, 0, 0, 0, 0, 0, 0
-    class SeenMap 
-    {
-    public:
-        //! Get the value of the block located in the given (x, y) position of the matrix.
-        //! \param x (int) the column of the 7x7 matrix.
-        //! \param y (int) the row of the 7x7 matrix.
-        //! \return value of the block, if the (x, y) is out of boundary, it returns the maximum integer value.
-        static int get_value(int x, int y) {
-            if (x > 6 || x < 0 || y < 0 || y > 6) {
-                return INT_MAX;
-            }
-            return map[y][x];
-        }
-
-        //! Increases the value of the block located in the given (x, y) position of the matrix by one.
-        //! \param x (int) the column of the 7x7 matrix.
-        //! \param y (int) the row of the 7x7 matrix.
-        static void set_to_visited(int x, int y) {
-            map[x][y] = map[x][y] + 1;
-        }
-
-        //! Resets all the values in the matrix to 0.
-        static void reset_map(){
-            for(int i = 0; i<7; i++){
-                for(int j = 0; j<7; j++) {
-                    map[i][j] = 0;
-                }
-            }
-        }
-
-        //! Prints the current state of the matrix to the standard output in the form of comma-separated values.
-        static void draw() {
-            for(int i = 0; i<7; i++){
-                for(int j = 0; j<7; j++) {
-                    std::cout << map[i][j] << ",";
-                }
-                std::cout<<std::endl;
-            }
-        }
-
-    private:
-    //! 2D vector that holds the values of the blocks in the matrix.
-    static std::vector<std::vector<int>> map;
-    };
-
-    //! Initialize the matrix, the values are initialized to 0 by default, the size is 7x7.
-    std::vector<std::vector<int>> SeenMap::map(7, std::vector<int>(7, 0));
+    //! The events of one WandererController, built on the elma event type.
+    typedef EventChannelOf<Event> EventChannel;
 
+    //! Angle of a heading, to render a grid pose. The grid pose is authoritative, the exact right angle
+    //! is only used to draw the robot.
+    inline double heading_angle(int heading) { return heading * M_PI_2; }
 
     //! Moving state, the robot should move to a specific location
     class Moving : public State, public AgentInterface
@@ -79,47 +44,117 @@ namespace
         //! A method that derived instances should define. It is called when the state is
         //! entered by the state machine either when the machine starts or when a transition
         //! to the state is fired.
-        //! \param e The event that led to the transition into the state, the value of the event is of form {x, y}
+        //! \param e The event that led to the transition into the state, the block to go to is events->cell_x, events->cell_y
         void entry(const Event &e) {
-            pos = e.value();
-            goal_x = 50.0+pos[0].get<int>()*100.0-350.0; // The x position the robot should move to
-            goal_y = 50.0+pos[1].get<int>()*100.0-350.0; // The y position the robot should move to
-            if (goal_x == 300 && goal_y == 400) {
-                goal_y = 350.0; // The boundry of the maze is 350.
+            target_column = events->cell_x;
+            target_row = events->cell_y;
+            if (telemetry != nullptr) {
+                telemetry->entered(Telemetry::MOVING);
+                // The step out through the exit is not a revisit, get_value() reads INT_MAX outside of the maze
+                telemetry->stepped(geometry->contains(target_column, target_row) && seen->get_value(target_column, target_row) > 0);
+            }
+            if (geometry->contains(target_column, target_row)) {
+                goal_x = geometry->center_x(target_column); // The x position the robot should move to
+                goal_y = geometry->center_y(target_row); // The y position the robot should move to
+            } else {
+                goal_x = geometry->exit_x(); // Out of the maze, the robot stops on its boundary
+                goal_y = geometry->exit_y();
+            }
+            seen->set_to_visited(pose->x, pose->y); // Set current block to visited
+            if (heatmap != nullptr) {
+                heatmap->touched(pose->x, pose->y);
+            }
+            if (stats != nullptr) {
+                stats->stepped(pose->x, pose->y);
             }
-            int cur_column = (position().x + 350.0) / 100.0;
-            int cur_row = (position().y + 350.0) / 100.0;
-            SeenMap::set_to_visited(cur_row, cur_column); // Set current block to visited
-            // SeenMap::draw();
         }
 
         void during()
         {
+            TelemetryScope scope(telemetry, Telemetry::MOVING);
             cur_x = position().x;
             cur_y = position().y;
-            // Keep robot moving toward the goal position.
-            if (std::fabs(cur_x - goal_x) >= 3 || std::fabs(cur_y - goal_y) >= 3){
+            // Keep robot moving toward the goal position, a kinematic robot is there at once.
+            if (!kinematic && (std::fabs(cur_x - goal_x) >= 3 || std::fabs(cur_y - goal_y) >= 3)){
                 move_toward(goal_x, goal_y, 30, 0);
             } else {
                 // teleport the robot to the goal position when it is close enough
-                teleport(goal_x, goal_y, angle());
-                if(goal_x == 300.0 && goal_y == 350.0){
-                    emit(Event("restart")); // Robot at maze exit
-                } else {
-                    emit(Event("check"));
+                teleport(goal_x, goal_y, heading_angle(pose->heading));
+                pose->x = target_column;
+                pose->y = target_row;
+                if (!geometry->contains(target_column, target_row)) {
+                    if (telemetry != nullptr) {
+                        telemetry->episode_end(true);
+                    }
+                    if (stats != nullptr) {
+                        stats->episode_end(true);
+                    }
+                    emit(events->restarting(0)); // Robot at maze exit
+                } else if (!pass_corridor()) {
+                    emit(events->checking());
                 }
             }
             
         }
+
+        //! In fast forward mode, carries on to the next block when the current one is a corridor,
+        //! without going through Checking and Rotating.
+        //! \return false when the robot has to decide where to go.
+        bool pass_corridor() {
+            if (corridors == nullptr || (solving != nullptr && *solving)) {
+                return false; // The solver decides in every block
+            }
+            int out = corridors->pass_heading(pose->x, pose->y, pose->heading);
+            if (out < 0) {
+                return false; // Junction, dead end or exit
+            }
+            target_column = pose->x + MazeGrid::dx(out);
+            target_row = pose->y + MazeGrid::dy(out);
+            if (telemetry != nullptr) {
+                telemetry->stepped(seen->get_value(target_column, target_row) > 0);
+                if (out != pose->heading) {
+                    telemetry->rotated();
+                }
+            }
+            if (trajectory != nullptr) {
+                trajectory->passed(*pose, out, *seen);
+            }
+            seen->set_to_visited(pose->x, pose->y); // Set current block to visited
+            if (heatmap != nullptr) {
+                heatmap->touched(pose->x, pose->y);
+            }
+            if (stats != nullptr) {
+                stats->stepped(pose->x, pose->y);
+            }
+            if (out != pose->heading) {
+                pose->heading = out;
+                teleport(goal_x, goal_y, heading_angle(out)); // Turn with the corridor
+            }
+            goal_x = geometry->center_x(target_column);
+            goal_y = geometry->center_y(target_row);
+            return true;
+        }
         void exit(const Event &e) {
         }
         void set_tick_name(std::string s) { tick_name = s; }
         std::string tick_name;
+        int target_column;
+        int target_row;
         double goal_x;
         double goal_y;
         double cur_x;
         double cur_y;
-        json pos;
+        GridPose *pose = nullptr;
+        EventChannel *events = nullptr;
+        SeenMap *seen = nullptr;
+        Telemetry *telemetry = nullptr;
+        const CorridorMap *corridors = nullptr; // Set in fast forward mode
+        const bool *solving = nullptr;
+        const GridGeometry *geometry = nullptr;
+        bool kinematic = false; // Go from block center to block center without the physics
+        TrajectoryRecorder *trajectory = nullptr;
+        HeatmapFeed *heatmap = nullptr;
+        VisitStatsFeed *stats = nullptr;
     };
 
     //! Rotating state, the robot should rotate 90 degrees
@@ -129,37 +164,33 @@ namespace
         //! A method that derived instances should define. It is called when the state is
         //! entered by the state machine either when the machine starts or when a transition
         //! to the state is fired.
-        //! \param e The event that led to the transition into the state, the value of the event is -1 or 0 or 1
-        //! the robot turns clockwise when value is 1, turns counter-clockwise when value is -1
+        //! \param e The event that led to the transition into the state, events->turn is -1 or 0 or 1
+        //! the robot turns clockwise when it is 1, turns counter-clockwise when it is -1
         void entry(const Event &e) { 
-            rate = e.value();
-            int degree_counter = angle() / 1.57;
-            // Calculate the goal angle
-            if (degree_counter >= 0) {
-                goal_angle = angle() - degree_counter * 1.57 >= 1.57/2 ? (degree_counter + 1) * 1.57 : degree_counter * 1.57;
-            } else {
-                goal_angle = std::fabs(angle() - degree_counter * 1.57) >= 1.57/2 ? (degree_counter-1) * 1.57 : degree_counter * 1.57;
-            }
-            if (rate != 0) {
-                goal_angle = goal_angle + rate * 1.57;
+            rate = events->turn;
+            if (telemetry != nullptr) {
+                telemetry->entered(Telemetry::ROTATING);
+                if (rate != 0) {
+                    telemetry->rotated();
+                }
             }
+            pose->rotate(rate); // A rate of 0 keeps the heading, the robot is only squared up
         }
         void during()
         {
-            // Set goal angle to 0 if the robot's angle is over a full circle (6.28)
-            if (goal_angle == 6.28 || goal_angle == -6.28) {
-                teleport(position().x, position().y, 0);
-            } else {
-                teleport(position().x, position().y, goal_angle);
-            }
-            emit(Event("check"));
+            TelemetryScope scope(telemetry, Telemetry::ROTATING);
+            teleport(geometry->center_x(pose->x), geometry->center_y(pose->y), heading_angle(pose->heading));
+            emit(events->checking());
 
         }
         void exit(const Event &e) {}
         double rate;
         void set_tick_name(std::string s) { tick_name = s; }
         std::string tick_name;
-        double goal_angle;
+        GridPose *pose = nullptr;
+        EventChannel *events = nullptr;
+        Telemetry *telemetry = nullptr;
+        const GridGeometry *geometry = nullptr;
     };
 
     //! Checking state, analyze current state and figure out next movement
@@ -168,217 +199,108 @@ namespace
     class Checking : public State, public AgentInterface
     {
     public:
+        //! Where the free space around the robot comes from.
+        //! GRID uses the wall grid compiled from config.json, SENSORS uses the range sensors,
+        //! VALIDATE uses the range sensors and reports every disagreement with the wall grid.
+        enum WallSource { GRID, SENSORS, VALIDATE };
+
         void entry(const Event &e) {
+            if (telemetry != nullptr) {
+                telemetry->entered(Telemetry::CHECKING);
+            }
         }
         void during()
         {
-            pos = position();
-            int cur_x = (pos.x + 350.0) / 100.0;
-            int cur_y = (pos.y + 350.0) / 100.0;
-            // Calculate where the robot is currently heading
-            double cur_angle = remainder(angle(), 1.57*4) >= 0 ? remainder(angle(), 1.57*4) : 6.28 + remainder(angle(), 1.57*4);
-            double direction = cur_angle/(1.57/2);
-            // robot at maze exit
-            if (cur_x == 6 and cur_y == 6) {
-                if(direction < 1|| direction >=7) {
-                    emit(Event("rotate", 1)); // Turn right to face the exit
-                } else if (direction >= 1 && direction < 3) {
-                    emit(Event("move", {cur_x, cur_y+1})); // Move to the boundry (exit)
-                } else if (direction >= 3 && direction < 5) {
-                    emit(Event("rotate", -1));
-                } else {
-                    emit(Event("rotate", 1));
-                }
+            TelemetryScope scope(telemetry, Telemetry::CHECKING);
+            if (!pose->valid) {
+                // Take over from the physics pose once, e.g. at the start
+                grid_pose(*this, pose->x, pose->y, pose->heading, *geometry);
+                pose->valid = true;
+            }
+            Decision d;
+            sensed = -1;
+            bool solved = solving && solver != nullptr && solver->decide(pose->x, pose->y, pose->heading, d);
+            if (!solved && planner != nullptr) {
+                d = planner->decide(*pose, *seen); // Plans on the wall grid
+            } else if (!solved) {
+                d = policy != nullptr ? explore_decision(*this, *pose, *seen, maze_exit, *policy)
+                                      : wander_decision(*this, *pose, *seen, maze_exit);
+            }
+            if ((trajectory != nullptr || stats != nullptr) && sensed < 0 && grid != nullptr) {
+                // The planner and the solver decide without sensing, read the walls from the grid instead of ray casting
+                sensed = grid->open_sides(pose->x, pose->y, pose->heading);
+            }
+            if (trajectory != nullptr) {
+                // Without a grid only the exit move is decided without sensing, once per episode
+                trajectory->decided(*pose, sensed >= 0 ? sensed : open_sides(pose->x, pose->y, pose->heading), d, *seen);
+            }
+            if (stats != nullptr && !solved && sensed == 0) {
+                stats->dead_end(pose->x, pose->y);
+            }
+            if (d.kind == Decision::MOVE) {
+                emit(events->moving_to(d.x, d.y));
             } else {
-                if (direction <1 || direction >=7){ // Heading right
-                    // No obstacles at all three directions, rigt, front, left
-                    if(sensor_value(0) > 100 && sensor_value(1) > 100 && sensor_value(2) > 100){
-                        // Block in front has the lowest visited times compare to block on the right and block on the left
-                        if(SeenMap::get_value(cur_x+1, cur_y) <= SeenMap::get_value(cur_x, cur_y-1) && SeenMap::get_value(cur_x+1, cur_y) <= SeenMap::get_value(cur_x, cur_y+1)) {
-                            emit(Event("move", {cur_x+1, cur_y})); // Move forward
-                        // Block on the right has the lowest visited times compare to block in front and block on the left
-                        } else if(SeenMap::get_value(cur_x, cur_y+1) <= SeenMap::get_value(cur_x+1, cur_y) && SeenMap::get_value(cur_x, cur_y+1) <= SeenMap::get_value(cur_x, cur_y-1)) {
-                            emit(Event("rotate", 1)); // Turn right
-                        } else {
-                            emit(Event("rotate", -1)); // Turn left
-                        }
-                    // No obstacles in front and on the right but on the left
-                    } else if (sensor_value(0) > 100 && sensor_value(1) > 100){
-                        // Block in front has lower visited times compare to the block on the right
-                        if(SeenMap::get_value(cur_x+1, cur_y) <= SeenMap::get_value(cur_x, cur_y+1)){
-                            emit(Event("move", {cur_x+1, cur_y})); // Move forward
-                        }else{
-                            emit(Event("rotate", 1)); // Turn right
-                        }
-                    // No obstacles in front and on the left but on the right
-                    } else if (sensor_value(0) > 100 && sensor_value(2) > 100){
-                        // Block in front has lower visited times compare to the block on the left
-                        if(SeenMap::get_value(cur_x+1, cur_y) <= SeenMap::get_value(cur_x, cur_y-1)){
-                            emit(Event("move", {cur_x+1, cur_y})); // Move forward
-                        }else{
-                            emit(Event("rotate", -1)); // Turn left
-                        }
-                    // No obstacles on the right and on the left but in front
-                    } else if (sensor_value(1) > 100 && sensor_value(2) > 100) {
-                        // Block on the right has lower visited times compare to block on the left
-                        if(SeenMap::get_value(cur_x, cur_y+1) <= SeenMap::get_value(cur_x, cur_y-1)){
-                            emit(Event("rotate", 1)); // Turn right
-                        } else {
-                            emit(Event("rotate", -1)); // Tuen left
-                        }
-                    } else if (sensor_value(0) > 100){
-                        emit(Event("move", {cur_x+1, cur_y}));
-                    } else if (sensor_value(1) > 100) {
-                        emit(Event("rotate", 1));
-                    } else if (sensor_value(2) > 100) {
-                        emit(Event("rotate", -1));
-                    } else {
-                        emit(Event("rotate", 1));
-                    }
-                } else if (direction >= 1 && direction <3 ){ // Heading down
-                    // No obstacles in all three directions, front, right, left
-                    if(sensor_value(0) > 100 && sensor_value(1) > 100 && sensor_value(2) > 100){
-                        // Block in front has the lowest visited times compare to block on the right and block on the left
-                        if(SeenMap::get_value(cur_x, cur_y+1) <= SeenMap::get_value(cur_x+1, cur_y) && SeenMap::get_value(cur_x, cur_y+1) <= SeenMap::get_value(cur_x-1, cur_y)) {
-                            emit(Event("move", {cur_x, cur_y+1})); // Move forward
-                        // Block on the right has the lowest visited times compare to block in front and block on the left
-                        } else if(SeenMap::get_value(cur_x-1, cur_y) <= SeenMap::get_value(cur_x, cur_y+1) && SeenMap::get_value(cur_x-1, cur_y) <= SeenMap::get_value(cur_x+1, cur_y)) {
-                            emit(Event("rotate", 1)); // Turn right
-                        } else {
-                            emit(Event("rotate", -1)); // Turn left
-                        }
-                    // No obstacles in front and on the right but on the left
-                    } else if (sensor_value(0) > 100 && sensor_value(1) > 100){
-                        // Block in front has lower visited times compare to the block on the right
-                        if(SeenMap::get_value(cur_x, cur_y+1) <= SeenMap::get_value(cur_x-1, cur_y)){
-                            emit(Event("move", {cur_x, cur_y+1})); // Move forward
-                        }else{
-                            emit(Event("rotate", 1)); // Turn right
-                        }
-                    //No obstacles in front and on the left but on the right
-                    } else if (sensor_value(0) > 100 && sensor_value(2) > 100){
-                        // Block in front has lower visited times compare to the block on the left
-                        if(SeenMap::get_value(cur_x, cur_y+1) <= SeenMap::get_value(cur_x+1, cur_y)){
-                            emit(Event("move", {cur_x, cur_y+1})); // Move forward
-                        }else{
-                            emit(Event("rotate", -1)); // Turn left
-                        }
-                    // No obstacles on the right and on the left but in front
-                    } else if (sensor_value(1) > 100 && sensor_value(2) > 100) {
-                        // Block on the right has lower visited times compare to block on the left
-                        if(SeenMap::get_value(cur_x-1, cur_y) <= SeenMap::get_value(cur_x+1, cur_y)){
-                            emit(Event("rotate", 1)); // Turn right
-                        } else {
-                            emit(Event("rotate", -1)); // Turn left
-                        }
-                    } else if (sensor_value(0) > 100){
-                        emit(Event("move", {cur_x, cur_y+1}));
-                    } else if (sensor_value(1) > 100) {
-                        emit(Event("rotate", 1));
-                    } else if (sensor_value(2) > 100) {
-                        emit(Event("rotate", -1));
-                    } else {
-                        emit(Event("rotate", 1));
-                    }
-                } else if (direction >= 3 && direction < 5){ // Heading left
-                    // No obstacles in all three directions, front, right, left
-                    if(sensor_value(0) > 100 && sensor_value(1) > 100 && sensor_value(2) > 100){
-                        // Block in front has the lowest visited times compare to block on the right and block on the left
-                        if(SeenMap::get_value(cur_x-1, cur_y) <= SeenMap::get_value(cur_x, cur_y+1) && SeenMap::get_value(cur_x-1, cur_y) <= SeenMap::get_value(cur_x, cur_y-1)) {
-                            emit(Event("move", {cur_x-1, cur_y})); // Move forward
-                        // Block on the right has the lowest visited times compare to block in front and block on the left
-                        } else if(SeenMap::get_value(cur_x, cur_y-1) <= SeenMap::get_value(cur_x-1, cur_y) && SeenMap::get_value(cur_x, cur_y-1) <= SeenMap::get_value(cur_x, cur_y+1)) {
-                            emit(Event("rotate", 1)); // Turn right
-                        } else {
-                            emit(Event("rotate", -1)); // Turn left
-                        }
-                    // No obstacles in front and on the right but on the left
-                    } else if (sensor_value(0) > 100 && sensor_value(1) > 100){
-                        // Block in front has lower visited times compare to the block on the right
-                        if(SeenMap::get_value(cur_x-1, cur_y) <= SeenMap::get_value(cur_x, cur_y-1)){
-                            emit(Event("move", {cur_x-1, cur_y})); // Move forward
-                        }else{
-                            emit(Event("rotate", 1)); // Turn right
-                        }
-                    // No obstacles in front and on the left but on the right
-                    } else if (sensor_value(0) > 100 && sensor_value(2) > 100){
-                        // Block in front has lower visited times compare to the block on the left
-                        if(SeenMap::get_value(cur_x-1, cur_y) <= SeenMap::get_value(cur_x, cur_y+1)){
-                            emit(Event("move", {cur_x-1, cur_y})); // Move forward
-                        }else{
-                            emit(Event("rotate", -1)); // Turn left
-                        }
-                    // No obstacles on the left and on the right but in front
-                    } else if (sensor_value(1) > 100 && sensor_value(2) > 100) {
-                        // Block on the right has lower visited times compare to the block on the left
-                        if(SeenMap::get_value(cur_x, cur_y-1) <= SeenMap::get_value(cur_x, cur_y+1)){
-                            emit(Event("rotate", 1)); // Turn right
-                        } else {
-                            emit(Event("rotate", -1)); // Turn left
-                        }
-                    } else if (sensor_value(0) > 100){
-                        emit(Event("move", {cur_x-1, cur_y}));
-                    } else if (sensor_value(1) > 100) {
-                        emit(Event("rotate", 1));
-                    } else if (sensor_value(2) > 100) {
-                        emit(Event("rotate", -1));
-                    } else {
-                        emit(Event("rotate", 1));
-                    }
-                } else { // Heading up
-                    // No obstacles in all three directions, front, right, left
-                    if(sensor_value(0) > 100 && sensor_value(1) > 100 && sensor_value(2) > 100){
-                        // Block in front has the lowest visited times compare to block on the right and block on the left
-                        if(SeenMap::get_value(cur_x, cur_y-1) <= SeenMap::get_value(cur_x+1, cur_y) && SeenMap::get_value(cur_x, cur_y-1) <= SeenMap::get_value(cur_x-1, cur_y)) {
-                            emit(Event("move", {cur_x, cur_y-1})); // Move forward
-                        // Block on the right has the lowest visited times compare to block in front and block on the left
-                        } else if(SeenMap::get_value(cur_x+1, cur_y) <= SeenMap::get_value(cur_x, cur_y-1) && SeenMap::get_value(cur_x+1, cur_y) <= SeenMap::get_value(cur_x-1, cur_y)) {
-                            emit(Event("rotate", 1)); // Turn right
-                        } else {
-                            emit(Event("rotate", -1)); // Turn left
-                        }
-                    // No obstacles in front and on the right but on the left
-                    } else if (sensor_value(0) > 100 && sensor_value(1) > 100){
-                        // Block in front has lower visited times compare to the block on the right
-                        if(SeenMap::get_value(cur_x, cur_y-1) <= SeenMap::get_value(cur_x+1, cur_y)){
-                            emit(Event("move", {cur_x, cur_y-1})); // Move forward
-                        }else{
-                            emit(Event("rotate", 1)); // Turn right
-                        }
-                    // No obstacles in front and on the left but on the right
-                    } else if (sensor_value(0) > 100 && sensor_value(2) > 100){
-                        // Block in front has lower visited times compare to the block on the left
-                        if(SeenMap::get_value(cur_x, cur_y-1) <= SeenMap::get_value(cur_x-1, cur_y)){
-                            emit(Event("move", {cur_x, cur_y-1})); // Move forward
-                        }else{
-                            emit(Event("rotate", -1)); // Turn left
-                        }
-                    // No obstacles on the left and on the right but in front
-                    } else if (sensor_value(1) > 100 && sensor_value(2) > 100) {
-                        // Block on the right has lower visited times compare to the block on the left
-                        if(SeenMap::get_value(cur_x+1, cur_y) <= SeenMap::get_value(cur_x-1, cur_y)){
-                            emit(Event("rotate", 1)); // Turn right
-                        } else {
-                            emit(Event("rotate", -1)); // Turn left
-                        }
-                    } else if (sensor_value(0) > 100){
-                        emit(Event("move", {cur_x, cur_y-1}));
-                    } else if (sensor_value(1) > 100) {
-                        emit(Event("rotate", 1));
-                    } else if (sensor_value(2) > 100) {
-                        emit(Event("rotate", -1));
-                    } else {
-                        emit(Event("rotate", 1));
-                    }
-                }
+                emit(events->rotating(d.rate));
+            }
+            if (telemetry != nullptr) {
+                telemetry->decided();
             }
-            
         }
         void exit(const Event &e) {}
+
+        //! Tells the policy which of the edges ahead, on the right and on the left of block (x, y) are open.
+        //! \return a free space mask made of OpenSide bits.
+        int open_sides(int x, int y, int heading) {
+            if (walls == GRID) {
+                return sensed = grid->open_sides(x, y, heading);
+            }
+            // Sensor 0 looks forward, sensor 1 to the right and sensor 2 to the left
+            int sensed = (sensor_value(0) > 100) * OPEN_FRONT
+                       | (sensor_value(1) > 100) * OPEN_RIGHT
+                       | (sensor_value(2) > 100) * OPEN_LEFT;
+            if (walls == VALIDATE && grid->open_sides(x, y, heading) != sensed) {
+                mismatches++;
+                if (first_mismatch(x, y)) {
+                    std::cout << "Checking: wall grid disagrees with the range sensors at (" << x << ", " << y
+                              << ") heading " << heading << ", grid " << grid->open_sides(x, y, heading)
+                              << " sensors " << sensed << ", the next ones in this block are only counted\n";
+                }
+            }
+            return this->sensed = sensed;
+        }
+
+        //! \return true the first time a mismatch is found in block (x, y).
+        bool first_mismatch(int x, int y) {
+            if (reported.size() != (size_t) grid->width() * grid->height()) {
+                reported.assign((size_t) grid->width() * grid->height(), 0);
+            }
+            if (!grid->in_bounds(x, y) || reported[(size_t) y * grid->width() + x]) {
+                return false;
+            }
+            reported[(size_t) y * grid->width() + x] = 1;
+            return true;
+        }
+
         double rate;
         void set_tick_name(std::string s) { tick_name = s; }
         std::string tick_name;
-        cpVect pos;
+        const MazeGrid *grid = nullptr;
+        MazeExit maze_exit;
+        WallSource walls = SENSORS;
+        long mismatches = 0; // Every disagreement of the grid and the sensors in VALIDATE mode
+        std::vector<char> reported; // Per block, a mismatch was printed
+        int sensed = -1; // The free space mask of the last decision, -1 before open_sides() is asked
+        ExplorationPolicy *policy = nullptr; // null for the built-in least visited rule
+        LookaheadPlanner *planner = nullptr; // null to decide greedily
+        MazeSolver *solver = nullptr;
+        bool solving = false; // Follow the solver instead of wandering
+        GridPose *pose = nullptr;
+        EventChannel *events = nullptr;
+        SeenMap *seen = nullptr;
+        Telemetry *telemetry = nullptr;
+        const GridGeometry *geometry = nullptr;
+        TrajectoryRecorder *trajectory = nullptr;
+        VisitStatsFeed *stats = nullptr;
     };
 
     //! Restart state, teleport the robot to the start position (x: -300, y:-300, theta: 0)
@@ -388,19 +310,42 @@ namespace
         //! A method that derived instances should define. It is called when the state is
         //! entered by the state machine either when the machine starts or when a transition
         //! to the state is fired.
-        //! \param e The event that led to the transition into the state, the value of the event is 1 or 0
-        //! event value is 1 means player is controlling the robot, otherwise the robot is wardering on its own.
+        //! \param e The event that led to the transition into the state, events->restart_player is 1 or 0
+        //! 1 means player is controlling the robot, otherwise the robot is wardering on its own.
         void entry(const Event &e) {
-            playing = e.value();
+            playing = events->restart_player;
+            if (telemetry != nullptr) {
+                telemetry->entered(Telemetry::RESTART);
+                telemetry->episode_end(false); // Restarted before the exit, no-op after one
+            }
+            if (stats != nullptr) {
+                stats->episode_end(false);
+            }
         }
         void during()
         {
-            teleport(-300, -300, 0); // Teleport the robot to start position
-            SeenMap::reset_map(); // clear the record
+            TelemetryScope scope(telemetry, Telemetry::RESTART);
+            *pose = { 0, 0, MazeGrid::RIGHT, true };
+            teleport(geometry->center_x(pose->x), geometry->center_y(pose->y), heading_angle(pose->heading)); // Teleport the robot to start position
+            if (!seen->is_shared()) {
+                seen->reset_map(); // clear the record, a shared record is still used by the other robots
+                if (trajectory != nullptr) {
+                    trajectory->restarted();
+                }
+                if (heatmap != nullptr) {
+                    heatmap->restarted();
+                }
+            }
+            if (policy != nullptr) {
+                policy->reset();
+            }
+            if (planner != nullptr) {
+                planner->reset();
+            }
             if (playing == 1) { // Player controlling
-                emit(Event("play", {0, 0})); // Transit to Inplay state
+                emit(events->playing(0, 0)); // Transit to Inplay state
             } else {
-                emit(Event("check"));
+                emit(events->checking());
             }
         }
         void exit(const Event &e) {
@@ -408,6 +353,16 @@ namespace
         void set_tick_name(std::string s) { tick_name = s; }
         std::string tick_name;
         int playing;
+        GridPose *pose = nullptr;
+        EventChannel *events = nullptr;
+        SeenMap *seen = nullptr;
+        Telemetry *telemetry = nullptr;
+        const GridGeometry *geometry = nullptr;
+        TrajectoryRecorder *trajectory = nullptr;
+        ExplorationPolicy *policy = nullptr;
+        LookaheadPlanner *planner = nullptr;
+        HeatmapFeed *heatmap = nullptr;
+        VisitStatsFeed *stats = nullptr;
     };
 
     //! Inplay state, player is controlling the robot
@@ -417,18 +372,23 @@ namespace
         //! A method that derived instances should define. It is called when the state is
         //! entered by the state machine either when the machine starts or when a transition
         //! to the state is fired.
-        //! \param e The event that led to the transition into the state, the value of the event 
-        //! is of form {velocity, angular velocity}
+        //! \param e The event that led to the transition into the state, the keys held before are dropped,
+        //! the player drives with the keys pressed from now on
         void entry(const Event &e) {
-            v = e.value()[0].get<double>(); // Get the velocity
-            av = e.value()[1].get<double>(); // Get the angular velocity
+            input->clear();
+            pose->valid = false; // The player drives the robot off the grid
+            if (telemetry != nullptr) {
+                telemetry->entered(Telemetry::INPLAY);
+            }
         }
         void during()
         {
+            TelemetryScope scope(telemetry, Telemetry::INPLAY);
             // Restart the game when robot gets to the exit of the maze.
-            if (position().x >= 350 || position().y >= 350) {
-                emit(Event("restart", 1));
+            if (geometry->past_edge(position().x, position().y)) {
+                emit(events->restarting(1));
             }
+            input->apply(v, av); // The keys held now, merged into one command per tick
             track_velocity(v, av);
         }
         void exit(const Event &e) {
@@ -437,34 +397,45 @@ namespace
         std::string tick_name;
         double v;
         double av;
+        PlayerInput *input = nullptr;
+        GridPose *pose = nullptr;
+        EventChannel *events = nullptr;
+        Telemetry *telemetry = nullptr;
+        const GridGeometry *geometry = nullptr;
     };
 
     //! GoToClosestCenter state, makes to robot go to the center of the current block
     class GoToClosestCenter : public State, public AgentInterface
     {
     public:
+        //! A method that derived instances should define. It is called when the state is
+        //! entered by the state machine either when the machine starts or when a transition
+        //! to the state is fired.
+        //! \param e The event that led to the transition into the state, events->solve_after is 1
+        //! when the robot should solve the maze afterwards, otherwise the robot is wandering on its own.
         void entry(const Event &e) {
-            cur_x = position().x;
-            cur_y = position().y;
-            // Calculate which block the robot is current in.
-            for(int i = 0; i < 7; i++){
-                if (cur_x >= -350 + i*100 && cur_x < -350 + (i+1)*100) {
-                    grid_x = 50.0+i*100.0-350.0;
-                }
-                if (cur_y >= -350 + i*100 && cur_y < -350 + (i+1)*100) {
-                    grid_y = 50.0+i*100.0-350.0;
-                }
+            if (solving != nullptr) {
+                *solving = events->solve_after == 1;
             }
+            if (telemetry != nullptr) {
+                telemetry->entered(Telemetry::GTCC);
+            }
+            // The robot ends in the center of the block it is in, squared up with the closest heading
+            grid_pose(*this, pose->x, pose->y, pose->heading, *geometry);
+            pose->valid = true;
+            grid_x = geometry->center_x(pose->x);
+            grid_y = geometry->center_y(pose->y);
         }
         void during()
         {
+            TelemetryScope scope(telemetry, Telemetry::GTCC);
             cur_x = position().x;
             cur_y = position().y;
             move_toward(grid_x, grid_y, 20, 10); // Move to the center of the current block
             if (std::fabs(cur_x - grid_x) < 1 && std::fabs(cur_y - grid_y) < 1){
                 track_velocity(0, 0);
-                teleport(grid_x, grid_y, angle()); // Teleport to the center when the robot is getting close
-                emit(Event("rotate", 0));
+                teleport(grid_x, grid_y, heading_angle(pose->heading)); // Teleport to the center when the robot is getting close
+                emit(events->rotating(0));
             }
         }
         void exit(const Event &e) {
@@ -473,9 +444,13 @@ namespace
         std::string tick_name;
         double cur_x;
         double cur_y;
-        int grid_x;
-        int grid_y;
-        double goal_angle;
+        double grid_x;
+        double grid_y;
+        bool *solving = nullptr;
+        GridPose *pose = nullptr;
+        EventChannel *events = nullptr;
+        Telemetry *telemetry = nullptr;
+        const GridGeometry *geometry = nullptr;
     };
 
 
@@ -484,38 +459,170 @@ namespace
     {
 
     public:
-        WandererController() : StateMachine()
+        WandererController() : StateMachine(), agent_id(next_id()), events(std::to_string(agent_id)), own_map(), seen(&own_map)
         {
             // Add all the transitions here
             set_initial(checking); // init with checking state
-            tick_name = "tick_" + std::to_string(rand() % 1000); // use an agent specific generated
-                                                                 // event name in case there are
-                                                                 // multiple instances of this class
+            tick_name = "tick_" + std::to_string(agent_id); // use an agent specific generated
+                                                            // event name in case there are
+                                                            // multiple instances of this class
             add_transition(tick_name, moving, rotating);
             add_transition(tick_name, rotating, moving);
-            add_transition("move", checking, moving);
-            add_transition("check", moving, checking);
-            add_transition("rotate", checking, rotating);
-            add_transition("check", rotating, checking);
-            add_transition("restart", moving,restarting);
-            add_transition("restart", rotating, restarting);
-            add_transition("restart", checking, restarting);
-            add_transition("restart", restarting, restarting);
-            add_transition("restart", playing, restarting);
-            add_transition("check", restarting, checking);
-            add_transition("rotate", gtcc, rotating);
-            add_transition("play", restarting, playing);
-            add_transition("play", moving, playing);
-            add_transition("play", rotating, playing);
-            add_transition("play", checking, playing);
-            add_transition("play", playing, playing);
-            add_transition("play", gtcc, playing);
-            add_transition("gtcc", playing, gtcc);
+            add_transition(events.move, checking, moving);
+            add_transition(events.check, moving, checking);
+            add_transition(events.rotate, checking, rotating);
+            add_transition(events.check, rotating, checking);
+            add_transition(events.restart, moving,restarting);
+            add_transition(events.restart, rotating, restarting);
+            add_transition(events.restart, checking, restarting);
+            add_transition(events.restart, restarting, restarting);
+            add_transition(events.restart, playing, restarting);
+            add_transition(events.check, restarting, checking);
+            add_transition(events.rotate, gtcc, rotating);
+            add_transition(events.play, restarting, playing);
+            add_transition(events.play, moving, playing);
+            add_transition(events.play, rotating, playing);
+            add_transition(events.play, checking, playing);
+            add_transition(events.play, playing, playing);
+            add_transition(events.play, gtcc, playing);
+            add_transition(events.gtcc, playing, gtcc);
+            add_transition(events.gtcc, moving, gtcc);
+            add_transition(events.gtcc, rotating, gtcc);
+            add_transition(events.gtcc, checking, gtcc);
+            gtcc.solving = &checking.solving;
+            moving.solving = &checking.solving;
+            moving.pose = rotating.pose = checking.pose = &pose;
+            restarting.pose = playing.pose = gtcc.pose = &pose;
+            moving.events = rotating.events = checking.events = &events;
+            restarting.events = playing.events = gtcc.events = &events;
+            playing.input = &input;
+            set_geometry(geometry);
+            set_seen_map(own_map);
             moving.set_tick_name(tick_name);
             rotating.set_tick_name(tick_name);
             checking.set_tick_name(tick_name);
         }
-        
+
+        //! Makes the robot map blocks to world positions with the given layout, the shipped maze by default.
+        void set_geometry(const GridGeometry &layout) {
+            geometry = layout;
+            moving.geometry = rotating.geometry = checking.geometry = &geometry;
+            restarting.geometry = playing.geometry = gtcc.geometry = &geometry;
+        }
+
+        //! Makes the robot record its visits in the given map, its own or one shared with other robots.
+        void set_seen_map(SeenMap &map) {
+            seen = &map;
+            moving.seen = checking.seen = restarting.seen = seen;
+        }
+
+        //! Starts counting and timing the states, the records are appended to the given file.
+        //! \param path (string) the JSON lines file, shared by every controller of the process.
+        //! \param interval (double) seconds between two snapshots of the counters.
+        void enable_telemetry(const std::string &path, double interval) {
+            telemetry = std::make_shared<Telemetry>(agent_id, std::vector<std::string>{
+                events.move, events.rotate, events.check, events.restart, events.play, events.gtcc }, interval);
+            moving.telemetry = rotating.telemetry = checking.telemetry = telemetry.get();
+            restarting.telemetry = playing.telemetry = gtcc.telemetry = telemetry.get();
+            telemetry->input = &input.statistics();
+            TelemetryWriter::instance(path, interval).add(telemetry);
+        }
+
+        //! Starts recording the decisions of the robot, see TrajectoryRecorder.
+        //! \param path (string) the trajectory file, replaced when it exists.
+        //! \param interval (int) steps between two keyframes of the visit map, 0 for the default.
+        void enable_trajectory(const std::string &path, int interval) {
+            trajectory.reset(new TrajectoryRecorder(path, seen->width(), seen->height(), interval));
+            moving.trajectory = checking.trajectory = restarting.trajectory = trajectory.get();
+        }
+
+        //! Streams the visit counts of the robot to the heatmap overlay, see HeatmapFeed.
+        void enable_heatmap() {
+            heatmap.reset(new HeatmapFeed(agent_id));
+            moving.heatmap = restarting.heatmap = heatmap.get();
+        }
+
+        //! Adds the visits, dead ends and episodes of the robot to statistics kept across runs.
+        //! \param store (VisitStats) the statistics, shared with the other robots.
+        //! \param prior (bool) true to make the policy avoid the dead ends found in the past episodes.
+        void enable_visit_stats(VisitStats &store, bool prior) {
+            stats.reset(new VisitStatsFeed(store));
+            moving.stats = checking.stats = restarting.stats = stats.get();
+            if (prior && policy != nullptr) {
+                policy->use_prior(&store);
+            }
+        }
+
+        //! Makes the robot plan its moves with rollouts of the least visited rule, see LookaheadPlanner.
+        //! \param grid (MazeGrid) the walls of the maze.
+        //! \param depth (int) decisions played by each rollout.
+        //! \param rollouts (int) rollouts for each way out of a junction.
+        //! \param threads (int) threads running the rollouts, this one included.
+        void enable_lookahead(const MazeGrid &grid, int depth, int rollouts, int threads) {
+            planner.reset(new LookaheadPlanner(grid, depth, rollouts, threads));
+            checking.planner = restarting.planner = planner.get();
+        }
+
+        //! Makes the robot wander with the given policy from now on.
+        //! \param name (string) one of policy_names().
+        //! \return false when the name is unknown, the policy is then left alone.
+        bool set_policy(const std::string &name) {
+            std::unique_ptr<ExplorationPolicy> next = make_policy(name);
+            if (next == nullptr) {
+                return false;
+            }
+            policy = std::move(next);
+            checking.policy = restarting.policy = policy.get();
+            return true;
+        }
+
+        void init() {
+            StateMachine::init();
+            if (heatmap != nullptr) {
+                watch("heatmap_sync", [this](Event &e) {
+                    heatmap->snapshot(); // An overlay has just started
+                });
+            }
+        }
+
+        //! Runs the state machine up to multiplier times per frame.
+        //! \param multiplier (int) state machine steps per frame, at least 1.
+        //! \param kinematic (bool) true to move the robot between block centers without the physics.
+        void accelerate(int multiplier, bool kinematic) {
+            steps_per_frame = std::max(1, multiplier);
+            moving.kinematic = kinematic;
+        }
+
+        //! Runs the current state, counting the ticks of the trajectory, then sends the blocks visited
+        //! during the frame to the heatmap overlay in one message.
+        //!
+        //! When accelerated, the state machine runs again within the same frame as long as the robot does
+        //! not wait for the physics, i.e. in Checking, Rotating, Restart, and in Moving when kinematic.
+        //! Only the pose at the end of the frame is drawn.
+        void update() {
+            for (int i = 0; i < steps_per_frame; i++) {
+                if (trajectory != nullptr) {
+                    trajectory->tick();
+                }
+                StateMachine::update();
+                State &state = current();
+                if (&state != &checking && &state != &rotating && &state != &restarting
+                    && !(&state == &moving && moving.kinematic)) {
+                    break; // Waits for the physics, or for the player
+                }
+            }
+            json message;
+            if (heatmap != nullptr && heatmap->collect(*seen, message)) {
+                emit(Event("heatmap", message));
+            }
+        }
+
+        //! \return a number that no other controller of this process uses.
+        static int next_id() {
+            static std::atomic<int> instances(0);
+            return instances++;
+        }
+
         Moving moving;
         Rotating rotating;
         Checking checking;
@@ -523,6 +630,20 @@ namespace
         Inplay playing;
         GoToClosestCenter gtcc;
         std::string tick_name;
+        int agent_id;
+        EventChannel events;
+        GridPose pose; // Authoritative in the autonomous modes
+        PlayerInput input; // The keys held by the player, read by Inplay
+        GridGeometry geometry; // The layout of the maze, the shipped one until the maze is loaded
+        SeenMap own_map;
+        SeenMap *seen;
+        std::shared_ptr<Telemetry> telemetry; // null when disabled
+        std::unique_ptr<TrajectoryRecorder> trajectory; // null when disabled
+        std::unique_ptr<ExplorationPolicy> policy; // null for the built-in least visited rule
+        std::unique_ptr<HeatmapFeed> heatmap; // null when disabled
+        std::unique_ptr<VisitStatsFeed> stats; // null when disabled
+        std::unique_ptr<LookaheadPlanner> planner; // null when disabled
+        int steps_per_frame = 1;
 
     };
 
@@ -536,79 +657,203 @@ namespace
             // Adds a label showing robot is being controlled by the player or self wandering
             label("wandering", -27, -20);
             playing = 0;
+            solving = 0;
             watch("button_click", [&](Event& e) {
                 if ( e.value()["value"] == "restart" ) {
-                    emit(Event("restart", playing));
+                    emit(events->restarting(playing));
                 }
                 if ( e.value()["value"] == "player" ) { // Player in control
                     if (playing == 0){
                         playing = 1; 
+                        solving = 0;
                         clear_label();
                         label("user playing", -33, -20);
-                        emit(Event("play", {0, 0}));
+                        emit(events->playing(0, 0));
                     }
                 }
                 if ( e.value()["value"] == "selfWander" ) { // Self wandering
-                    if (playing == 1){
+                    if (playing == 1 || solving == 1){
                         playing = 0;
+                        solving = 0;
                         clear_label();
                         label("wandering", -27, -20);
-                        emit(Event("gtcc")); // Go to the closest center first then starts wandering
+                        emit(events->going_to_center(0)); // Go to the closest center first then starts wandering
+                    }
+                }
+                if ( e.value()["value"] == "solve" ) { // Follow the shortest route to the exit
+                    if (solving == 0){
+                        playing = 0;
+                        solving = 1;
+                        clear_label();
+                        label("solving", -22, -20);
+                        emit(events->going_to_center(1)); // Go to the closest center first then starts solving
                     }
                 }
             });
+            // The keys only update the held keys, Inplay reads the command once per tick
             watch("keydown", [&](Event &e) {
                 // Use A, W, S, D keys to control the robot
-                if(position().x < 350 && position().y < 350){ // within the maze boundry
+                if (!geometry->past_edge(position().x, position().y)) { // within the maze boundry
                     if (playing == 1) {
-                        auto k = e.value()["key"].get<std::string>();
-                        if ( k == "w" ) {
-                            v = v_m;
-                        } else if ( k == "s" ) {
-                            v = -v_m;
-                        } else if ( k == "a" ) {
-                            omega = -omega_m;
-                        } else if ( k == "d" ) {
-                            omega = omega_m;
-                        }
-                        emit(Event("play", {v, omega}));
+                        input->press(e.value()["key"].get<std::string>());
                     }
                 }
             });
             watch("keyup", [&](Event &e) {
-                if(position().x < 350 && position().y < 350){ // within the maze boundry 
-                    if (playing == 1) {
-                        auto k = e.value()["key"].get<std::string>();
-                        if ( k == "w" || k == "s" ) {
-                            v = 0;               
-                        } else if ( k == "a" ) {
-                            omega = 0;
-                        } else if ( k == "d" ) {
-                            omega = 0;
-                        } 
-                        emit(Event("play", {v, omega}));
-                    }
+                if (playing == 1) { // Also outside the maze, so no key stays held
+                    input->release(e.value()["key"].get<std::string>());
                 }
             });
         }
 
         void start() {}
-        void update() {}
+        void update() {
+            // Show the last telemetry snapshot under the robot
+            if (telemetry != nullptr && telemetry->display_version() != shown_version) {
+                shown_version = telemetry->display_version();
+                decorate("<text x='-40' y='28' font-size='8'>" + telemetry->display() + "</text>");
+            }
+        }
         void stop() {}
 
         double z = 1.0;
         int playing = 0;
-        double v, omega;
-        double const v_m = 5, omega_m = 0.5;
+        int solving = 0;
+        PlayerInput *input = nullptr; // The keys held, owned by this robot's WandererController
+        EventChannel *events = nullptr; // The events of this robot's WandererController
+        const GridGeometry *geometry = nullptr; // The layout of the maze of this robot's WandererController
+        const Telemetry *telemetry = nullptr; // Counters shown on screen, null when not displayed
+        long shown_version = -1;
 
     };
 
+    //! The walls of the maze, loaded once and shared by every Wanderer: from the grid file maze_gen wrote
+    //! beside config.json (config.grid) when there is one, so a big maze is not rasterized from its
+    //! statics, compiled from config.json otherwise. The grid is empty when the maze can not be read.
+    //! \param path (string) a grid or config file to load instead, only used by the first call.
+    MazeGrid &maze(const std::string &path = "") {
+        static MazeGrid grid = [&path]() {
+            try {
+                return MazeGrid::load(path.empty() ? MazeGrid::grid_beside("config.json") : path);
+            } catch (std::exception &e) {
+                std::cout << "Wanderer: " << e.what() << ", falling back to the range sensors" << std::endl;
+                return MazeGrid();
+            }
+        }();
+        return grid;
+    }
+
+    //! The distance-to-exit field of the maze, computed once and shared by every Wanderer.
+    MazeSolver &maze_solver() {
+        static MazeSolver solver(maze());
+        return solver;
+    }
+
+    //! The decision points of the maze for the fast forward mode, computed once and shared by every Wanderer.
+    CorridorMap &maze_corridors() {
+        static CorridorMap corridors(maze(), MazeExit::of(maze()));
+        return corridors;
+    }
+
+    //! The visit map of the robots that cooperate, sized like the maze and shared by every Wanderer
+    //! configured with "visit_map": "shared".
+    SeenMap &shared_seen_map() {
+        static SeenMap map(std::max(maze().width(), 1), std::max(maze().height(), 1), true);
+        return map;
+    }
+
+    //! The visit statistics kept across runs, opened once and shared by every Wanderer that enables them.
+    //! \param path (string) the statistics file, only used by the first call.
+    //! \return null when the file can not be used.
+    VisitStats *maze_visit_stats(const std::string &path) {
+        static std::unique_ptr<VisitStats> stats = [&path]() {
+            try {
+                return std::unique_ptr<VisitStats>(new VisitStats(path, maze().width(), maze().height()));
+            } catch (std::exception &e) {
+                std::cout << "Wanderer: " << e.what() << ", the visit statistics are not kept" << std::endl;
+                return std::unique_ptr<VisitStats>();
+            }
+        }();
+        return stats.get();
+    }
+
     class Wanderer : public Agent
     {
 
     public:
         Wanderer(json spec, World &world) : Agent(spec, world)
         {
+            // Size the visit map and compile the walls from the maze definition
+            json options = spec.value("wanderer", json::object());
+            const MazeGrid &grid = maze(options.value("grid", ""));
+            std::string walls = options.value("walls", "grid");
+            if (options.value("visit_map", "private") == "shared") {
+                wc.set_seen_map(shared_seen_map()); // Cooperate with the other robots
+            }
+            if (grid.width() == 0) {
+                wc.checking.walls = Checking::SENSORS; // No grid to check the walls with
+            } else {
+                wc.own_map.resize(grid.width(), grid.height());
+                wc.set_geometry(GridGeometry::of(grid));
+                wc.checking.grid = &grid;
+                wc.checking.maze_exit = MazeExit::of(grid);
+                wc.checking.solver = &maze_solver();
+                wc.checking.walls = walls == "sensors" ? Checking::SENSORS
+                                  : walls == "validate" ? Checking::VALIDATE : Checking::GRID;
+            }
+            std::string policy = options.value("policy", "least_visited");
+            if (policy == "auto" && grid.width() > 0) {
+                // Race the policies on this maze from the start block, the cheapest one wins
+                long budget = std::max(1000L, 16L * grid.width() * grid.height());
+                policy = fastest_policy(grid, policy_names(), 0, 0, MazeGrid::RIGHT, budget);
+                std::cout << "Wanderer: policy auto picked " << policy << std::endl;
+            }
+            if (!wc.set_policy(policy)) {
+                std::cout << "Wanderer: unknown policy " << policy << ", using least_visited" << std::endl;
+            }
+            if (grid.width() > 0 && options.value("fast_forward", false)
+                && (wc.policy == nullptr || wc.policy->follows_corridors())) {
+                wc.moving.corridors = &maze_corridors(); // Go through corridors without stopping
+            }
+            json lookahead = options.value("lookahead", json::object());
+            if (lookahead.value("enabled", false) && grid.width() > 0) {
+                wc.enable_lookahead(grid, lookahead.value("depth", 32), lookahead.value("rollouts", 4), lookahead.value("threads", 1));
+            }
+            json time = options.value("time", json::object());
+            wc.accelerate(time.value("multiplier", 1), time.value("kinematic", false));
+            wpc.events = &wc.events;
+            wpc.input = &wc.input;
+            wpc.geometry = &wc.geometry;
+            json telemetry = options.value("telemetry", json::object());
+            if (telemetry.value("enabled", false)) {
+                wc.enable_telemetry(telemetry.value("file", "telemetry.jsonl"), telemetry.value("interval", 1.0));
+                if (telemetry.value("display", true)) {
+                    wpc.telemetry = wc.telemetry.get();
+                }
+            }
+            json trajectory = options.value("trajectory", json::object());
+            if (trajectory.value("enabled", false)) {
+                // One file per robot: trajectory.wtr becomes trajectory_0.wtr, trajectory_1.wtr ...
+                std::string file = trajectory.value("file", "trajectory.wtr");
+                size_t dot = file.find_last_of('.'), slash = file.find_last_of('/');
+                bool extension = dot != std::string::npos && (slash == std::string::npos || dot > slash);
+                file.insert(extension ? dot : file.size(), "_" + std::to_string(wc.agent_id));
+                try {
+                    wc.enable_trajectory(file, trajectory.value("keyframe_interval", 0));
+                } catch (std::exception &e) {
+                    std::cout << "Wanderer: " << e.what() << ", the trajectory is not recorded" << std::endl;
+                }
+            }
+            if (options.value("heatmap", false)) {
+                wc.enable_heatmap();
+            }
+            json visit_stats = options.value("visit_stats", json::object());
+            if (visit_stats.value("enabled", false) && grid.width() > 0) {
+                VisitStats *store = maze_visit_stats(visit_stats.value("file", "visit_stats.wvs"));
+                if (store != nullptr) {
+                    wc.enable_visit_stats(*store, visit_stats.value("prior", true));
+                }
+            }
             // Adds two processes
             add_process(wc); 
             add_process(wpc);